@@ -0,0 +1,329 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "GameFramework/GameplayMessageCapture.h"
+#include "GameFramework/GameplayMessageSubsystem.h"
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/ObjectAndNameAsStringProxyArchive.h"
+#include "UObject/Class.h"
+
+//////////////////////////////////////////////////////////////////////
+// FGameplayMessageCaptureWriter
+
+FGameplayMessageCaptureWriter::FGameplayMessageCaptureWriter(const FString& InFilename)
+	: Filename(InFilename)
+{
+	FileWriter.Reset(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!FileWriter.IsValid())
+	{
+		UE_LOG(LogGameplayMessageSubsystem, Error, TEXT("Failed to open gameplay message capture file %s"), *Filename);
+		return;
+	}
+
+	StartTime = FPlatformTime::Seconds();
+
+	FMemoryWriter HeaderWriter(FrameBuffer);
+	uint32 Magic = UE::GameplayMessageSubsystem::Capture::FileMagic;
+	int32 Version = UE::GameplayMessageSubsystem::Capture::FileVersion;
+	HeaderWriter << Magic;
+	HeaderWriter << Version;
+
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("GameplayMessageCaptureWriter"), 0, TPri_BelowNormal);
+}
+
+FGameplayMessageCaptureWriter::~FGameplayMessageCaptureWriter()
+{
+	SubmitFrame();
+
+	if (Thread != nullptr)
+	{
+		// The thread drains everything still queued before it exits
+		Thread->Kill(/*bShouldWait=*/ true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (WorkEvent != nullptr)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+		WorkEvent = nullptr;
+	}
+
+	if (FileWriter.IsValid())
+	{
+		FileWriter->Close();
+		FileWriter.Reset();
+	}
+}
+
+void FGameplayMessageCaptureWriter::RecordMessage(FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes)
+{
+	check(IsInGameThread());
+
+	int32 ChannelIndex = GetChannelIndex(Channel);
+	int32 StructIndex = GetStructIndex(StructType);
+
+	PayloadScratch.Reset();
+	FMemoryWriter PayloadWriter(PayloadScratch);
+	FObjectAndNameAsStringProxyArchive PayloadArchive(PayloadWriter, /*bInLoadIfFindFails=*/ false);
+	const_cast<UScriptStruct*>(StructType)->SerializeItem(PayloadArchive, const_cast<void*>(MessageBytes), /*Defaults=*/ nullptr);
+
+	FMemoryWriter Writer(FrameBuffer);
+	Writer.Seek(FrameBuffer.Num());
+
+	uint8 RecordType = uint8(UE::GameplayMessageSubsystem::Capture::ERecordType::Message);
+	double Timestamp = FPlatformTime::Seconds() - StartTime;
+	uint32 PayloadSize = PayloadScratch.Num();
+
+	Writer << RecordType;
+	Writer << Timestamp;
+	Writer.SerializeIntPacked(reinterpret_cast<uint32&>(ChannelIndex));
+	Writer.SerializeIntPacked(reinterpret_cast<uint32&>(StructIndex));
+	Writer.SerializeIntPacked(PayloadSize);
+	Writer.Serialize(PayloadScratch.GetData(), PayloadScratch.Num());
+
+	++NumMessagesRecorded;
+}
+
+void FGameplayMessageCaptureWriter::SubmitFrame()
+{
+	if ((FrameBuffer.Num() == 0) || !FileWriter.IsValid())
+	{
+		return;
+	}
+
+	if (Thread != nullptr)
+	{
+		PendingBuffers.Enqueue(MoveTemp(FrameBuffer));
+		FrameBuffer.Reset();
+		WorkEvent->Trigger();
+	}
+	else
+	{
+		// No writer thread (e.g. the platform doesn't support threading), write the frame right away
+		FileWriter->Serialize(FrameBuffer.GetData(), FrameBuffer.Num());
+		FrameBuffer.Reset();
+	}
+}
+
+int32 FGameplayMessageCaptureWriter::GetChannelIndex(FGameplayTag Channel)
+{
+	if (const int32* pIndex = ChannelIndices.Find(Channel.GetTagName()))
+	{
+		return *pIndex;
+	}
+
+	return ChannelIndices.Add(Channel.GetTagName(), AddName(Channel.ToString()));
+}
+
+int32 FGameplayMessageCaptureWriter::GetStructIndex(const UScriptStruct* StructType)
+{
+	if (const int32* pIndex = StructIndices.Find(FObjectKey(StructType)))
+	{
+		return *pIndex;
+	}
+
+	return StructIndices.Add(FObjectKey(StructType), AddName(StructType->GetPathName()));
+}
+
+int32 FGameplayMessageCaptureWriter::AddName(const FString& Name)
+{
+	FMemoryWriter Writer(FrameBuffer);
+	Writer.Seek(FrameBuffer.Num());
+
+	uint8 RecordType = uint8(UE::GameplayMessageSubsystem::Capture::ERecordType::Name);
+	uint32 Index = NumNames++;
+	FString NameCopy = Name;
+
+	Writer << RecordType;
+	Writer.SerializeIntPacked(Index);
+	Writer << NameCopy;
+
+	return int32(Index);
+}
+
+uint32 FGameplayMessageCaptureWriter::Run()
+{
+	double LastFlushTime = FPlatformTime::Seconds();
+
+	while (!bStopRequested.load(std::memory_order_acquire))
+	{
+		WorkEvent->Wait(FTimespan::FromMilliseconds(100.0));
+		WritePendingBuffers();
+
+		// Flush periodically so a crash loses at most a second of traffic
+		const double Now = FPlatformTime::Seconds();
+		if (Now - LastFlushTime >= 1.0)
+		{
+			FileWriter->Flush();
+			LastFlushTime = Now;
+		}
+	}
+
+	WritePendingBuffers();
+	FileWriter->Flush();
+
+	return 0;
+}
+
+void FGameplayMessageCaptureWriter::Stop()
+{
+	bStopRequested.store(true, std::memory_order_release);
+	WorkEvent->Trigger();
+}
+
+void FGameplayMessageCaptureWriter::WritePendingBuffers()
+{
+	TArray<uint8> Buffer;
+	while (PendingBuffers.Dequeue(Buffer))
+	{
+		FileWriter->Serialize(Buffer.GetData(), Buffer.Num());
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// FGameplayMessageReplay
+
+FGameplayMessageReplay::FGameplayMessageReplay(const FString& InFilename, float InPlaybackRate)
+	: Filename(InFilename)
+	, PlaybackRate(FMath::Max(InPlaybackRate, 0.0f))
+{
+	if (!FFileHelper::LoadFileToArray(FileData, *Filename))
+	{
+		UE_LOG(LogGameplayMessageSubsystem, Error, TEXT("Failed to read gameplay message capture file %s"), *Filename);
+		return;
+	}
+
+	bLoaded = Parse();
+}
+
+bool FGameplayMessageReplay::Parse()
+{
+	using namespace UE::GameplayMessageSubsystem::Capture;
+
+	FMemoryReader Reader(FileData);
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic;
+	Reader << Version;
+
+	if (Reader.IsError() || (Magic != FileMagic) || (Version != FileVersion))
+	{
+		UE_LOG(LogGameplayMessageSubsystem, Error, TEXT("%s is not a gameplay message capture (or uses an unsupported version)"), *Filename);
+		return false;
+	}
+
+	while (!Reader.AtEnd() && !Reader.IsError())
+	{
+		uint8 RecordType = 0;
+		Reader << RecordType;
+
+		if (RecordType == uint8(ERecordType::Name))
+		{
+			uint32 Index = 0;
+			FString Name;
+			Reader.SerializeIntPacked(Index);
+			Reader << Name;
+
+			if (int32(Index) >= Names.Num())
+			{
+				Names.SetNum(Index + 1);
+				Channels.SetNum(Index + 1);
+				Structs.SetNum(Index + 1);
+			}
+			Names[Index] = MoveTemp(Name);
+		}
+		else if (RecordType == uint8(ERecordType::Message))
+		{
+			FRecord& Record = Records.AddDefaulted_GetRef();
+			uint32 ChannelIndex = 0;
+			uint32 StructIndex = 0;
+			uint32 PayloadSize = 0;
+
+			Reader << Record.Timestamp;
+			Reader.SerializeIntPacked(ChannelIndex);
+			Reader.SerializeIntPacked(StructIndex);
+			Reader.SerializeIntPacked(PayloadSize);
+
+			Record.ChannelIndex = ChannelIndex;
+			Record.StructIndex = StructIndex;
+			Record.PayloadOffset = Reader.Tell();
+			Record.PayloadSize = PayloadSize;
+
+			if (Reader.IsError() || !Names.IsValidIndex(Record.ChannelIndex) || !Names.IsValidIndex(Record.StructIndex) || (Record.PayloadOffset + int64(PayloadSize) > FileData.Num()))
+			{
+				Records.Pop();
+				Reader.SetError();
+				break;
+			}
+
+			Reader.Seek(Record.PayloadOffset + PayloadSize);
+
+			// Resolve each name once, in the role it is first used in
+			if (!Channels[Record.ChannelIndex].IsValid())
+			{
+				Channels[Record.ChannelIndex] = FGameplayTag::RequestGameplayTag(FName(*Names[Record.ChannelIndex]), /*ErrorIfNotFound=*/ false);
+			}
+			if (Structs[Record.StructIndex].IsExplicitlyNull())
+			{
+				Structs[Record.StructIndex] = LoadObject<UScriptStruct>(nullptr, *Names[Record.StructIndex]);
+			}
+		}
+		else
+		{
+			Reader.SetError();
+		}
+	}
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogGameplayMessageSubsystem, Warning, TEXT("Gameplay message capture %s is truncated or corrupt, replaying the first %d messages"), *Filename, Records.Num());
+	}
+
+	return true;
+}
+
+bool FGameplayMessageReplay::Advance(TFunctionRef<void(FGameplayTag, const UScriptStruct*, const void*)> Broadcast)
+{
+	const double Now = FPlatformTime::Seconds();
+	if (StartTime < 0.0)
+	{
+		StartTime = Now;
+	}
+
+	const double PlaybackTime = (PlaybackRate > 0.0f) ? (Now - StartTime) * PlaybackRate : TNumericLimits<double>::Max();
+
+	while ((NextRecord < Records.Num()) && (Records[NextRecord].Timestamp <= PlaybackTime))
+	{
+		const FRecord& Record = Records[NextRecord++];
+
+		const FGameplayTag Channel = Channels[Record.ChannelIndex];
+		const UScriptStruct* StructType = Structs[Record.StructIndex].Get();
+		if (!Channel.IsValid() || (StructType == nullptr))
+		{
+			++NumSkipped;
+			continue;
+		}
+
+		void* Payload = FMemory::Malloc(FMath::Max(StructType->GetStructureSize(), 1), StructType->GetMinAlignment());
+		StructType->InitializeStruct(Payload);
+
+		FMemoryReaderView PayloadReader(MakeArrayView(FileData.GetData() + Record.PayloadOffset, Record.PayloadSize));
+		FObjectAndNameAsStringProxyArchive PayloadArchive(PayloadReader, /*bInLoadIfFindFails=*/ true);
+		const_cast<UScriptStruct*>(StructType)->SerializeItem(PayloadArchive, Payload, /*Defaults=*/ nullptr);
+
+		Broadcast(Channel, StructType, Payload);
+
+		StructType->DestroyStruct(Payload);
+		FMemory::Free(Payload);
+	}
+
+	return NextRecord < Records.Num();
+}
@@ -0,0 +1,144 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "Containers/Queue.h"
+#include "GameplayTagContainer.h"
+#include "HAL/Runnable.h"
+#include "Templates/Function.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/WeakObjectPtr.h"
+
+#include <atomic>
+
+class FArchive;
+class FEvent;
+class FRunnableThread;
+class UScriptStruct;
+
+/**
+ * Capture file layout:
+ *   uint32 Magic, int32 Version
+ *   followed by records, each starting with an ERecordType byte:
+ *     Name:    packed int Index, FString Name (a channel tag or struct path, written the first time it is used)
+ *     Message: double Timestamp, packed int ChannelIndex, packed int StructIndex, packed int PayloadSize, Payload bytes
+ *
+ * Payloads are tagged property streams with object references stored as paths, so captures survive struct layout changes.
+ */
+namespace UE::GameplayMessageSubsystem::Capture
+{
+	static constexpr uint32 FileMagic = 0x47534D47; // 'GMSG'
+	static constexpr int32 FileVersion = 1;
+
+	enum class ERecordType : uint8
+	{
+		Name = 0,
+		Message = 1,
+	};
+}
+
+/**
+ * Records broadcasts into a capture file
+ * Messages are serialized on the game thread into a per-frame buffer, the file itself is written by a background thread
+ * (or on the game thread, when the writer thread could not be created)
+ */
+class FGameplayMessageCaptureWriter final : public FRunnable
+{
+public:
+	explicit FGameplayMessageCaptureWriter(const FString& InFilename);
+	virtual ~FGameplayMessageCaptureWriter() override;
+
+	bool IsOpen() const { return FileWriter.IsValid(); }
+	const FString& GetFilename() const { return Filename; }
+	int64 GetNumMessagesRecorded() const { return NumMessagesRecorded; }
+
+	// Serializes a broadcast into the current frame buffer (game thread only)
+	void RecordMessage(FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes);
+
+	// Hands the current frame buffer over to the writer thread (game thread only)
+	void SubmitFrame();
+
+	//~FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~End of FRunnable interface
+
+private:
+	int32 GetChannelIndex(FGameplayTag Channel);
+	int32 GetStructIndex(const UScriptStruct* StructType);
+	int32 AddName(const FString& Name);
+
+	void WritePendingBuffers();
+
+private:
+	FString Filename;
+	TUniquePtr<FArchive> FileWriter;
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WorkEvent = nullptr;
+	std::atomic<bool> bStopRequested{ false };
+
+	// Frame buffers waiting to be written to disk
+	TQueue<TArray<uint8>, EQueueMode::Spsc> PendingBuffers;
+
+	// Game thread state
+	TArray<uint8> FrameBuffer;
+	TArray<uint8> PayloadScratch;
+	TMap<FName, int32> ChannelIndices;
+	TMap<FObjectKey, int32> StructIndices;
+	int32 NumNames = 0;
+	int64 NumMessagesRecorded = 0;
+	double StartTime = 0.0;
+};
+
+/**
+ * Plays back a capture file by re-broadcasting its messages with their original relative timing
+ */
+class FGameplayMessageReplay
+{
+public:
+	FGameplayMessageReplay(const FString& InFilename, float InPlaybackRate);
+
+	// False if the file could not be read or is not a capture
+	bool IsLoaded() const { return bLoaded; }
+
+	const FString& GetFilename() const { return Filename; }
+	int32 GetNumMessages() const { return Records.Num(); }
+	int32 GetNumMessagesPlayed() const { return NextRecord; }
+	int32 GetNumMessagesSkipped() const { return NumSkipped; }
+
+	/**
+	 * Broadcasts every message that is due, the first call starts the playback clock
+	 * @return true while there are messages left to play
+	 */
+	bool Advance(TFunctionRef<void(FGameplayTag, const UScriptStruct*, const void*)> Broadcast);
+
+private:
+	bool Parse();
+
+private:
+	struct FRecord
+	{
+		double Timestamp = 0.0;
+		int32 ChannelIndex = INDEX_NONE;
+		int32 StructIndex = INDEX_NONE;
+		int32 PayloadOffset = 0;
+		int32 PayloadSize = 0;
+	};
+
+	FString Filename;
+	TArray<uint8> FileData;
+	TArray<FRecord> Records;
+
+	// Indexed by name index, only the entries used in the respective role are resolved
+	TArray<FString> Names;
+	TArray<FGameplayTag> Channels;
+	TArray<TWeakObjectPtr<const UScriptStruct>> Structs;
+
+	// A rate of 0 plays everything as fast as possible
+	float PlaybackRate = 1.0f;
+	double StartTime = -1.0;
+	int32 NextRecord = 0;
+	int32 NumSkipped = 0;
+	bool bLoaded = false;
+};
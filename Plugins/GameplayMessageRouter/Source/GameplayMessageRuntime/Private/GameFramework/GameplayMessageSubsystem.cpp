@@ -4,6 +4,13 @@
 #include "Engine/Engine.h"
 #include "Engine/GameInstance.h"
 #include "Engine/World.h"
+#include "GameFramework/GameplayMessageCapture.h"
+#include "HAL/FileManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/OutputDevice.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
 #include "UObject/ScriptMacros.h"
 #include "UObject/Stack.h"
 
@@ -11,6 +18,13 @@
 
 DEFINE_LOG_CATEGORY(LogGameplayMessageSubsystem);
 
+DECLARE_STATS_GROUP(TEXT("GameplayMessages"), STATGROUP_GameplayMessages, STATCAT_Advanced);
+DECLARE_CYCLE_STAT(TEXT("Broadcast Message"), STAT_GameplayMessages_Broadcast, STATGROUP_GameplayMessages);
+DECLARE_CYCLE_STAT(TEXT("Drain Thread Safe Messages"), STAT_GameplayMessages_DrainThreadSafe, STATGROUP_GameplayMessages);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Thread Safe Queue Depth"), STAT_GameplayMessages_ThreadSafeQueueDepth, STATGROUP_GameplayMessages);
+
+CSV_DEFINE_CATEGORY(GameplayMessages, false);
+
 namespace UE
 {
 	namespace GameplayMessageSubsystem
@@ -19,6 +33,73 @@ namespace UE
 		static FAutoConsoleVariableRef CVarShouldLogMessages(TEXT("GameplayMessageSubsystem.LogMessages"),
 			ShouldLogMessages,
 			TEXT("Should messages broadcast through the gameplay message subsystem be logged?"));
+
+		static bool bShouldCollectStats = false;
+		static FAutoConsoleVariableRef CVarShouldCollectStats(TEXT("GameplayMessageSubsystem.CollectStats"),
+			bShouldCollectStats,
+			TEXT("Should per-channel broadcast counts and callback timings be collected? (see GameplayMessageSubsystem.DumpStats and the GameplayMessages CSV category)"));
+
+		static FAutoConsoleCommandWithWorldArgsAndOutputDevice CmdDumpStats(TEXT("GameplayMessageSubsystem.DumpStats"),
+			TEXT("Prints the per-channel counters collected while GameplayMessageSubsystem.CollectStats is enabled. Pass 'reset' to clear them afterwards."),
+			FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+			{
+				if ((World == nullptr) || !UGameplayMessageSubsystem::HasInstance(World))
+				{
+					Ar.Log(TEXT("No gameplay message subsystem for this world"));
+					return;
+				}
+
+				UGameplayMessageSubsystem& Router = UGameplayMessageSubsystem::Get(World);
+				Router.DumpChannelStats(Ar);
+
+				if ((Args.Num() > 0) && (Args[0] == TEXT("reset")))
+				{
+					Router.ResetChannelStats();
+				}
+			}));
+
+		static FAutoConsoleCommandWithWorldAndArgs CmdStartCapture(TEXT("GameplayMessageSubsystem.StartCapture"),
+			TEXT("Streams every gameplay message broadcast to a binary capture file. Usage: GameplayMessageSubsystem.StartCapture [Filename]"),
+			FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+			{
+				if ((World != nullptr) && UGameplayMessageSubsystem::HasInstance(World))
+				{
+					UGameplayMessageSubsystem::Get(World).StartMessageCapture((Args.Num() > 0) ? Args[0] : FString());
+				}
+			}));
+
+		static FAutoConsoleCommandWithWorld CmdStopCapture(TEXT("GameplayMessageSubsystem.StopCapture"),
+			TEXT("Stops a capture started with GameplayMessageSubsystem.StartCapture"),
+			FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+			{
+				if ((World != nullptr) && UGameplayMessageSubsystem::HasInstance(World))
+				{
+					UGameplayMessageSubsystem::Get(World).StopMessageCapture();
+				}
+			}));
+
+		static FAutoConsoleCommandWithWorldAndArgs CmdReplay(TEXT("GameplayMessageSubsystem.Replay"),
+			TEXT("Re-broadcasts a gameplay message capture. Usage: GameplayMessageSubsystem.Replay <Filename> [PlaybackRate=1, 0 for as fast as possible]"),
+			FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+			{
+				if ((Args.Num() == 0) || (World == nullptr) || !UGameplayMessageSubsystem::HasInstance(World))
+				{
+					return;
+				}
+
+				const float PlaybackRate = (Args.Num() > 1) ? FCString::Atof(*Args[1]) : 1.0f;
+				UGameplayMessageSubsystem::Get(World).StartMessageReplay(Args[0], PlaybackRate);
+			}));
+
+		static FAutoConsoleCommandWithWorld CmdStopReplay(TEXT("GameplayMessageSubsystem.StopReplay"),
+			TEXT("Stops a replay started with GameplayMessageSubsystem.Replay"),
+			FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+			{
+				if ((World != nullptr) && UGameplayMessageSubsystem::HasInstance(World))
+				{
+					UGameplayMessageSubsystem::Get(World).StopMessageReplay();
+				}
+			}));
 	}
 }
 
@@ -33,6 +114,7 @@ void FGameplayMessageListenerHandle::Unregister()
 		Subsystem.Reset();
 		Channel = FGameplayTag();
 		ID = 0;
+		SlotIndex = INDEX_NONE;
 	}
 }
 
@@ -55,15 +137,74 @@ bool UGameplayMessageSubsystem::HasInstance(const UObject* WorldContextObject)
 	return Router != nullptr;
 }
 
+void UGameplayMessageSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &ThisClass::HandleWorldPostActorTick);
+
+	// Listener struct types are validated when compatibility is cached, so anything that can unload or replace a struct must invalidate it
+	PostGarbageCollectHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &ThisClass::HandlePostGarbageCollect);
+#if WITH_RELOAD
+	ReloadCompleteHandle = FCoreUObjectDelegates::ReloadCompleteDelegate.AddWeakLambda(this, [this](EReloadCompleteReason) { InvalidateAllDispatchTables(); });
+#endif
+
+	ChannelStatsStartTime = ChannelStatsWindowStartTime = FPlatformTime::Seconds();
+}
+
 void UGameplayMessageSubsystem::Deinitialize()
 {
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+	PostActorTickHandle.Reset();
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGarbageCollectHandle);
+	PostGarbageCollectHandle.Reset();
+#if WITH_RELOAD
+	FCoreUObjectDelegates::ReloadCompleteDelegate.Remove(ReloadCompleteHandle);
+	ReloadCompleteHandle.Reset();
+#endif
+
+	StopMessageCapture();
+	StopMessageReplay();
+
+	// Drop anything still pending, there is nobody left to deliver it to
+	for (FThreadSafeMessage* Node = ThreadSafeMessageHead.exchange(nullptr, std::memory_order_acquire); Node != nullptr; )
+	{
+		FThreadSafeMessage* Next = Node->Next;
+		ReleaseThreadSafeMessage(Node);
+		Node = Next;
+	}
+	ThreadSafeMessageCount.store(0, std::memory_order_relaxed);
+
+	while (FThreadSafeMessage* Node = ThreadSafeMessagePool.Pop())
+	{
+		delete Node;
+	}
+
+	for (const FDeferredMessage& Message : DeferredMessages)
+	{
+		Message.StructType->DestroyStruct(Message.Payload);
+	}
+	DeferredMessages.Reset();
+	DeferredMessageIndices.Reset();
+	DeferredMessageArenas[0].Empty();
+	DeferredMessageArenas[1].Empty();
+
 	ListenerMap.Reset();
+	DispatchTables.Reset();
+	ChannelStats.Reset();
+
+	ListenerSlotPages.Empty();
+	NumListenerSlots = 0;
+	FirstFreeListenerSlot = INDEX_NONE;
+	PendingFreeListenerSlots.Empty();
 
 	Super::Deinitialize();
 }
 
 void UGameplayMessageSubsystem::BroadcastMessageInternal(FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes)
 {
+	SCOPE_CYCLE_COUNTER(STAT_GameplayMessages_Broadcast);
+
 	// Log the message if enabled
 	if (UE::GameplayMessageSubsystem::ShouldLogMessages != 0)
 	{
@@ -81,44 +222,556 @@ void UGameplayMessageSubsystem::BroadcastMessageInternal(FGameplayTag Channel, c
 		UE_LOG(LogGameplayMessageSubsystem, Log, TEXT("BroadcastMessage(%s, %s, %s)"), pContextString ? **pContextString : *GetPathNameSafe(this), *Channel.ToString(), *HumanReadableMessage);
 	}
 
+	if (CaptureWriter.IsValid())
+	{
+		CaptureWriter->RecordMessage(Channel, StructType, MessageBytes);
+	}
+
 	// Broadcast the message
+	// Holding a reference keeps the table alive even if a callback causes it to be rebuilt
+	const TSharedRef<const FChannelDispatchTable> DispatchTable = GetDispatchTable(Channel);
+
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(*DispatchTable->TraceEventName);
+
+	// Accumulated locally and written once at the end, a callback may add channels and invalidate references into ChannelStats
+	const bool bCollectStats = UE::GameplayMessageSubsystem::bShouldCollectStats;
+	uint64 NumDeliveries = 0;
+	uint64 NumTypeMismatches = 0;
+	uint64 TotalCallbackCycles = 0;
+	uint64 MaxCallbackCycles = 0;
+
+	// Slots unregistered while we are iterating are only freed once the outermost broadcast finishes
+	++BroadcastDepth;
+
+	const FChannelDispatchTable::FStructCompatibility& Compatibility = GetStructCompatibility(*DispatchTable, StructType);
+
+	// Every entry in the mask already accepts this struct type, only removals made by earlier callbacks need checking
+	for (TConstSetBitIterator<> It(Compatibility.CompatibleEntries); It; ++It)
+	{
+		const FChannelDispatchTable::FEntry& Entry = DispatchTable->Entries[It.GetIndex()];
+		const FListenerSlot& Slot = GetListenerSlot(Entry.SlotIndex);
+
+		// Removed by an earlier callback during this broadcast
+		if (!Slot.bInUse || (Slot.SlotGeneration != Entry.SlotGeneration))
+		{
+			continue;
+		}
+
+		if (bCollectStats)
+		{
+			const uint64 StartCycles = FPlatformTime::Cycles64();
+			Slot.Data.ReceivedCallback(Channel, StructType, MessageBytes);
+			const uint64 CallbackCycles = FPlatformTime::Cycles64() - StartCycles;
+
+			++NumDeliveries;
+			TotalCallbackCycles += CallbackCycles;
+			MaxCallbackCycles = FMath::Max(MaxCallbackCycles, CallbackCycles);
+		}
+		else
+		{
+			Slot.Data.ReceivedCallback(Channel, StructType, MessageBytes);
+		}
+	}
+
+	for (int32 EntryIndex : Compatibility.StaleEntries)
+	{
+		const FChannelDispatchTable::FEntry& Entry = DispatchTable->Entries[EntryIndex];
+		const FListenerSlot& Slot = GetListenerSlot(Entry.SlotIndex);
+		if (Slot.bInUse && (Slot.SlotGeneration == Entry.SlotGeneration))
+		{
+			UE_LOG(LogGameplayMessageSubsystem, Warning, TEXT("Listener struct type has gone invalid on Channel %s. Removing listener from list"), *Channel.ToString());
+			UnregisterListenerInternal(Entry.SlotIndex, Entry.SlotGeneration);
+		}
+	}
+
+	for (int32 EntryIndex : Compatibility.MismatchedEntries)
+	{
+		const FChannelDispatchTable::FEntry& Entry = DispatchTable->Entries[EntryIndex];
+		const FListenerSlot& Slot = GetListenerSlot(Entry.SlotIndex);
+		if (Slot.bInUse && (Slot.SlotGeneration == Entry.SlotGeneration))
+		{
+			++NumTypeMismatches;
+
+			UE_LOG(LogGameplayMessageSubsystem, Error, TEXT("Struct type mismatch on channel %s (broadcast type %s, listener at %s was expecting type %s)"),
+				*Channel.ToString(),
+				*StructType->GetPathName(),
+				*Slot.Channel.ToString(),
+				*GetPathNameSafe(Slot.Data.ListenerStructType.Get()));
+		}
+	}
+
+	if (bCollectStats)
+	{
+		FGameplayMessageChannelStats& Stats = ChannelStats.FindOrAdd(Channel);
+		++Stats.NumBroadcasts;
+		++Stats.NumBroadcastsThisFrame;
+		++Stats.NumBroadcastsThisWindow;
+		Stats.NumDeliveries += NumDeliveries;
+		Stats.NumTypeMismatches += NumTypeMismatches;
+		Stats.TotalCallbackCycles += TotalCallbackCycles;
+		Stats.MaxCallbackCycles = FMath::Max(Stats.MaxCallbackCycles, MaxCallbackCycles);
+		Stats.NumListeners = DispatchTable->Entries.Num();
+	}
+
+	if ((--BroadcastDepth == 0) && (PendingFreeListenerSlots.Num() > 0))
+	{
+		for (int32 SlotIndex : PendingFreeListenerSlots)
+		{
+			FreeListenerSlot(SlotIndex);
+		}
+		PendingFreeListenerSlots.Reset();
+	}
+}
+
+TSharedRef<const UGameplayMessageSubsystem::FChannelDispatchTable> UGameplayMessageSubsystem::GetDispatchTable(FGameplayTag Channel)
+{
+	// Never modify a table in place, a broadcast further up the stack may still be iterating it
+	TSharedRef<FChannelDispatchTable> NewTable = MakeShared<FChannelDispatchTable>();
+
+	if (const TSharedRef<const FChannelDispatchTable>* pExistingTable = DispatchTables.Find(Channel))
+	{
+		if (!(*pExistingTable)->bStale)
+		{
+			return *pExistingTable;
+		}
+		NewTable->TraceEventName = (*pExistingTable)->TraceEventName;
+	}
+	else
+	{
+		NewTable->TraceEventName = FString::Printf(TEXT("GameplayMessage %s"), *Channel.ToString());
+	}
+
 	bool bOnInitialTag = true;
 	for (FGameplayTag Tag = Channel; Tag.IsValid(); Tag = Tag.RequestDirectParent())
 	{
 		if (const FChannelListenerList* pList = ListenerMap.Find(Tag))
 		{
-			// Copy in case there are removals while handling callbacks
-			TArray<FGameplayMessageListenerData> ListenerArray(pList->Listeners);
-
-			for (const FGameplayMessageListenerData& Listener : ListenerArray)
+			for (int32 SlotIndex : pList->ListenerSlots)
 			{
-				if (bOnInitialTag || (Listener.MatchType == EGameplayMessageMatch::PartialMatch))
+				const FListenerSlot& Slot = GetListenerSlot(SlotIndex);
+				if (bOnInitialTag || (Slot.Data.MatchType == EGameplayMessageMatch::PartialMatch))
 				{
-					if (Listener.bHadValidType && !Listener.ListenerStructType.IsValid())
-					{
-						UE_LOG(LogGameplayMessageSubsystem, Warning, TEXT("Listener struct type has gone invalid on Channel %s. Removing listener from list"), *Channel.ToString());
-						UnregisterListenerInternal(Channel, Listener.HandleID);
-						continue;
-					}
-
-					// The receiving type must be either a parent of the sending type or completely ambiguous (for internal use)
-					if (!Listener.bHadValidType || StructType->IsChildOf(Listener.ListenerStructType.Get()))
-					{
-						Listener.ReceivedCallback(Channel, StructType, MessageBytes);
-					}
-					else
-					{
-						UE_LOG(LogGameplayMessageSubsystem, Error, TEXT("Struct type mismatch on channel %s (broadcast type %s, listener at %s was expecting type %s)"),
-							*Channel.ToString(),
-							*StructType->GetPathName(),
-							*Tag.ToString(),
-							*Listener.ListenerStructType->GetPathName());
-					}
+					NewTable->Entries.Add({ SlotIndex, Slot.SlotGeneration });
 				}
 			}
 		}
 		bOnInitialTag = false;
 	}
+
+	DispatchTables.Add(Channel, NewTable);
+	return NewTable;
+}
+
+const UGameplayMessageSubsystem::FChannelDispatchTable::FStructCompatibility& UGameplayMessageSubsystem::GetStructCompatibility(const FChannelDispatchTable& DispatchTable, const UScriptStruct* StructType)
+{
+	for (const TUniquePtr<FChannelDispatchTable::FStructCompatibility>& Compatibility : DispatchTable.CompatibilityCache)
+	{
+		if (Compatibility->BroadcastStructType == StructType)
+		{
+			return *Compatibility;
+		}
+	}
+
+	FChannelDispatchTable::FStructCompatibility& NewCompatibility = *DispatchTable.CompatibilityCache.Add_GetRef(MakeUnique<FChannelDispatchTable::FStructCompatibility>());
+	NewCompatibility.BroadcastStructType = StructType;
+	NewCompatibility.BroadcastStructTypeWeak = StructType;
+	NewCompatibility.CompatibleEntries.Init(false, DispatchTable.Entries.Num());
+
+	for (int32 EntryIndex = 0; EntryIndex < DispatchTable.Entries.Num(); ++EntryIndex)
+	{
+		const FGameplayMessageListenerData& Listener = GetListenerSlot(DispatchTable.Entries[EntryIndex].SlotIndex).Data;
+
+		if (Listener.bHadValidType && !Listener.ListenerStructType.IsValid())
+		{
+			NewCompatibility.StaleEntries.Add(EntryIndex);
+		}
+		// The receiving type must be either a parent of the sending type or completely ambiguous (for internal use)
+		else if (!Listener.bHadValidType || StructType->IsChildOf(Listener.ListenerStructType.Get()))
+		{
+			NewCompatibility.CompatibleEntries[EntryIndex] = true;
+		}
+		else
+		{
+			NewCompatibility.MismatchedEntries.Add(EntryIndex);
+		}
+	}
+
+	return NewCompatibility;
+}
+
+void UGameplayMessageSubsystem::InvalidateDispatchTables(FGameplayTag Channel, EGameplayMessageMatch MatchType)
+{
+	if (MatchType == EGameplayMessageMatch::ExactMatch)
+	{
+		if (const TSharedRef<const FChannelDispatchTable>* pTable = DispatchTables.Find(Channel))
+		{
+			(*pTable)->bStale = true;
+		}
+		return;
+	}
+
+	for (const TPair<FGameplayTag, TSharedRef<const FChannelDispatchTable>>& Pair : DispatchTables)
+	{
+		if (Pair.Key.MatchesTag(Channel))
+		{
+			Pair.Value->bStale = true;
+		}
+	}
+}
+
+void UGameplayMessageSubsystem::InvalidateAllDispatchTables()
+{
+	for (const TPair<FGameplayTag, TSharedRef<const FChannelDispatchTable>>& Pair : DispatchTables)
+	{
+		Pair.Value->bStale = true;
+	}
+}
+
+void UGameplayMessageSubsystem::HandlePostGarbageCollect()
+{
+	for (const TPair<FGameplayTag, TSharedRef<const FChannelDispatchTable>>& Pair : DispatchTables)
+	{
+		const FChannelDispatchTable& Table = *Pair.Value;
+		if (Table.bStale)
+		{
+			continue;
+		}
+
+		// Cached compatibility for a broadcast type that is gone could be picked up by a new struct at the same address
+		for (const TUniquePtr<FChannelDispatchTable::FStructCompatibility>& Compatibility : Table.CompatibilityCache)
+		{
+			Table.bStale |= !Compatibility->BroadcastStructTypeWeak.IsValid();
+		}
+
+		// Listeners whose type was unloaded since the compatibility was cached have to be moved to the stale entries
+		for (int32 EntryIndex = 0; (EntryIndex < Table.Entries.Num()) && !Table.bStale; ++EntryIndex)
+		{
+			const FChannelDispatchTable::FEntry& Entry = Table.Entries[EntryIndex];
+			const FListenerSlot& Slot = GetListenerSlot(Entry.SlotIndex);
+			Table.bStale = Slot.bInUse && (Slot.SlotGeneration == Entry.SlotGeneration) && Slot.Data.bHadValidType && !Slot.Data.ListenerStructType.IsValid();
+		}
+	}
+}
+
+void UGameplayMessageSubsystem::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	Super::AddReferencedObjects(InThis, Collector);
+
+	// Deferred payloads may hold object references across a garbage collection before they are flushed
+	UGameplayMessageSubsystem* This = CastChecked<UGameplayMessageSubsystem>(InThis);
+	for (FDeferredMessage& Message : This->DeferredMessages)
+	{
+		Collector.AddReferencedObject(Message.StructType, This);
+		Collector.AddPropertyReferencesWithStructARO(Message.StructType, Message.Payload, This);
+	}
+}
+
+void UGameplayMessageSubsystem::BroadcastMessageDeferredInternal(FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes, uint64 CoalescingKey, FDeferredMessageMergeFunc MergeFunc)
+{
+	check(IsInGameThread());
+
+	if (CoalescingKey != 0)
+	{
+		const FDeferredMessageKey Key{ Channel, StructType, CoalescingKey };
+		if (const int32* pPendingIndex = DeferredMessageIndices.Find(Key))
+		{
+			MergeFunc(DeferredMessages[*pPendingIndex].Payload, MessageBytes);
+			return;
+		}
+
+		DeferredMessageIndices.Add(Key, DeferredMessages.Num());
+	}
+
+	FDeferredMessage& Message = DeferredMessages.AddDefaulted_GetRef();
+	Message.Channel = Channel;
+	Message.StructType = StructType;
+	Message.Payload = DeferredMessageArenas[ActiveDeferredMessageArena].Allocate(StructType->GetStructureSize(), StructType->GetMinAlignment());
+
+	StructType->InitializeStruct(Message.Payload);
+	StructType->CopyScriptStruct(Message.Payload, MessageBytes);
+}
+
+void UGameplayMessageSubsystem::FlushDeferredMessages()
+{
+	if (DeferredMessages.Num() == 0)
+	{
+		return;
+	}
+
+	// Anything deferred by a listener during the flush is queued into the other arena and delivered next time
+	TArray<FDeferredMessage> MessagesToDeliver = MoveTemp(DeferredMessages);
+	DeferredMessages.Reset();
+	DeferredMessageIndices.Reset();
+
+	FDeferredMessageArena& ArenaToRelease = DeferredMessageArenas[ActiveDeferredMessageArena];
+	ActiveDeferredMessageArena ^= 1;
+
+	for (const FDeferredMessage& Message : MessagesToDeliver)
+	{
+		BroadcastMessageInternal(Message.Channel, Message.StructType, Message.Payload);
+	}
+
+	for (const FDeferredMessage& Message : MessagesToDeliver)
+	{
+		Message.StructType->DestroyStruct(Message.Payload);
+	}
+
+	ArenaToRelease.Reset();
+}
+
+void UGameplayMessageSubsystem::HandleWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetGameInstance()->GetWorld())
+	{
+		if (Replay.IsValid())
+		{
+			const bool bReplayInProgress = Replay->Advance([this](FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes)
+			{
+				BroadcastMessageInternal(Channel, StructType, MessageBytes);
+			});
+
+			if (!bReplayInProgress)
+			{
+				StopMessageReplay();
+			}
+		}
+
+		DrainThreadSafeMessages();
+		FlushDeferredMessages();
+		UpdateChannelStats();
+
+		if (CaptureWriter.IsValid())
+		{
+			CaptureWriter->SubmitFrame();
+		}
+	}
+}
+
+bool UGameplayMessageSubsystem::StartMessageCapture(const FString& Filename)
+{
+	StopMessageCapture();
+
+	if (Replay.IsValid())
+	{
+		UE_LOG(LogGameplayMessageSubsystem, Warning, TEXT("Can't capture gameplay messages while replaying %s, stop the replay first"), *Replay->GetFilename());
+		return false;
+	}
+
+	const FString CaptureFilename = !Filename.IsEmpty() ? Filename : FPaths::ProfilingDir() / TEXT("GameplayMessages") / FString::Printf(TEXT("Capture-%s.gmcap"), *FDateTime::Now().ToString());
+	IFileManager::Get().MakeDirectory(*FPaths::GetPath(CaptureFilename), /*Tree=*/ true);
+
+	TPimplPtr<FGameplayMessageCaptureWriter> NewWriter = MakePimpl<FGameplayMessageCaptureWriter>(CaptureFilename);
+	if (!NewWriter->IsOpen())
+	{
+		return false;
+	}
+
+	UE_LOG(LogGameplayMessageSubsystem, Log, TEXT("Started capturing gameplay messages to %s"), *CaptureFilename);
+	CaptureWriter = MoveTemp(NewWriter);
+	return true;
+}
+
+void UGameplayMessageSubsystem::StopMessageCapture()
+{
+	if (CaptureWriter.IsValid())
+	{
+		UE_LOG(LogGameplayMessageSubsystem, Log, TEXT("Stopped capturing gameplay messages to %s (%lld messages)"), *CaptureWriter->GetFilename(), CaptureWriter->GetNumMessagesRecorded());
+		CaptureWriter.Reset();
+	}
+}
+
+bool UGameplayMessageSubsystem::StartMessageReplay(const FString& Filename, float PlaybackRate)
+{
+	StopMessageReplay();
+
+	if (CaptureWriter.IsValid())
+	{
+		UE_LOG(LogGameplayMessageSubsystem, Warning, TEXT("Can't replay gameplay messages while capturing to %s, stop the capture first"), *CaptureWriter->GetFilename());
+		return false;
+	}
+
+	TPimplPtr<FGameplayMessageReplay> NewReplay = MakePimpl<FGameplayMessageReplay>(Filename, PlaybackRate);
+	if (!NewReplay->IsLoaded())
+	{
+		return false;
+	}
+
+	UE_LOG(LogGameplayMessageSubsystem, Log, TEXT("Replaying %d gameplay messages from %s at %.2fx"), NewReplay->GetNumMessages(), *Filename, PlaybackRate);
+	Replay = MoveTemp(NewReplay);
+	return true;
+}
+
+void UGameplayMessageSubsystem::StopMessageReplay()
+{
+	if (Replay.IsValid())
+	{
+		UE_LOG(LogGameplayMessageSubsystem, Log, TEXT("Finished replaying %s (%d of %d messages played, %d skipped)"),
+			*Replay->GetFilename(), Replay->GetNumMessagesPlayed(), Replay->GetNumMessages(), Replay->GetNumMessagesSkipped());
+		Replay.Reset();
+	}
+}
+
+void UGameplayMessageSubsystem::UpdateChannelStats()
+{
+	if (ChannelStats.Num() == 0)
+	{
+		return;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	const double WindowDuration = Now - ChannelStatsWindowStartTime;
+	const bool bWindowComplete = WindowDuration >= 1.0;
+
+#if CSV_PROFILER
+	const bool bRecordCsvStats = FCsvProfiler::Get()->IsCapturing() && FCsvProfiler::Get()->IsCategoryEnabled(CSV_CATEGORY_INDEX(GameplayMessages));
+	int32 TotalBroadcastsThisFrame = 0;
+#endif
+
+	for (TPair<FGameplayTag, FGameplayMessageChannelStats>& Pair : ChannelStats)
+	{
+		FGameplayMessageChannelStats& Stats = Pair.Value;
+
+#if CSV_PROFILER
+		if (bRecordCsvStats && (Stats.NumBroadcastsThisFrame > 0))
+		{
+			FCsvProfiler::RecordCustomStat(Pair.Key.GetTagName(), CSV_CATEGORY_INDEX(GameplayMessages), Stats.NumBroadcastsThisFrame, ECsvCustomStatOp::Set);
+		}
+		TotalBroadcastsThisFrame += Stats.NumBroadcastsThisFrame;
+#endif
+
+		Stats.NumBroadcastsThisFrame = 0;
+
+		if (bWindowComplete)
+		{
+			Stats.BroadcastsPerSecond = float(Stats.NumBroadcastsThisWindow / WindowDuration);
+			Stats.NumBroadcastsThisWindow = 0;
+		}
+	}
+
+#if CSV_PROFILER
+	if (bRecordCsvStats)
+	{
+		CSV_CUSTOM_STAT(GameplayMessages, TotalBroadcasts, TotalBroadcastsThisFrame, ECsvCustomStatOp::Set);
+	}
+#endif
+
+	if (bWindowComplete)
+	{
+		ChannelStatsWindowStartTime = Now;
+	}
+}
+
+void UGameplayMessageSubsystem::ResetChannelStats()
+{
+	ChannelStats.Reset();
+	ChannelStatsStartTime = ChannelStatsWindowStartTime = FPlatformTime::Seconds();
+}
+
+void UGameplayMessageSubsystem::DumpChannelStats(FOutputDevice& Ar) const
+{
+	if (!UE::GameplayMessageSubsystem::bShouldCollectStats && (ChannelStats.Num() == 0))
+	{
+		Ar.Log(TEXT("No gameplay message stats collected, enable them with GameplayMessageSubsystem.CollectStats 1"));
+		return;
+	}
+
+	TArray<TPair<FGameplayTag, FGameplayMessageChannelStats>> SortedStats = ChannelStats.Array();
+	SortedStats.Sort([](const TPair<FGameplayTag, FGameplayMessageChannelStats>& A, const TPair<FGameplayTag, FGameplayMessageChannelStats>& B)
+	{
+		return A.Value.TotalCallbackCycles > B.Value.TotalCallbackCycles;
+	});
+
+	const double CollectionDuration = FPlatformTime::Seconds() - ChannelStatsStartTime;
+
+	Ar.Logf(TEXT("Gameplay message stats for %s over %.1f seconds:"), *GetPathNameSafe(this), CollectionDuration);
+	Ar.Logf(TEXT("%-60s %10s %10s %10s %10s %12s %12s %10s"), TEXT("Channel"), TEXT("Broadcasts"), TEXT("Per sec"), TEXT("Listeners"), TEXT("Deliveries"), TEXT("Total ms"), TEXT("Max ms"), TEXT("Mismatch"));
+
+	for (const TPair<FGameplayTag, FGameplayMessageChannelStats>& Pair : SortedStats)
+	{
+		const FGameplayMessageChannelStats& Stats = Pair.Value;
+		Ar.Logf(TEXT("%-60s %10llu %10.1f %10d %10llu %12.3f %12.3f %10llu"),
+			*Pair.Key.ToString(),
+			Stats.NumBroadcasts,
+			Stats.BroadcastsPerSecond,
+			Stats.NumListeners,
+			Stats.NumDeliveries,
+			FPlatformTime::ToMilliseconds64(Stats.TotalCallbackCycles),
+			FPlatformTime::ToMilliseconds64(Stats.MaxCallbackCycles),
+			Stats.NumTypeMismatches);
+	}
+}
+
+UGameplayMessageSubsystem::FThreadSafeMessage* UGameplayMessageSubsystem::AllocateThreadSafeMessage(int32 PayloadSize)
+{
+	FThreadSafeMessage* Node = ThreadSafeMessagePool.Pop();
+	if (Node == nullptr)
+	{
+		Node = new FThreadSafeMessage();
+	}
+
+	Node->Payload = (PayloadSize <= FThreadSafeMessage::InlinePayloadSize) ? Node->InlinePayload : FMemory::Malloc(PayloadSize, FThreadSafeMessage::InlinePayloadAlignment);
+	return Node;
+}
+
+void UGameplayMessageSubsystem::SubmitThreadSafeMessage(FThreadSafeMessage* Node)
+{
+	FThreadSafeMessage* OldHead = ThreadSafeMessageHead.load(std::memory_order_relaxed);
+	do
+	{
+		Node->Next = OldHead;
+	}
+	while (!ThreadSafeMessageHead.compare_exchange_weak(OldHead, Node, std::memory_order_release, std::memory_order_relaxed));
+
+	ThreadSafeMessageCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void UGameplayMessageSubsystem::ReleaseThreadSafeMessage(FThreadSafeMessage* Node)
+{
+	Node->DestroyPayload(Node->Payload);
+	if (Node->Payload != Node->InlinePayload)
+	{
+		FMemory::Free(Node->Payload);
+	}
+
+	Node->Payload = nullptr;
+	Node->Next = nullptr;
+	ThreadSafeMessagePool.Push(Node);
+}
+
+void UGameplayMessageSubsystem::DrainThreadSafeMessages()
+{
+	check(IsInGameThread());
+	SCOPE_CYCLE_COUNTER(STAT_GameplayMessages_DrainThreadSafe);
+
+	SET_DWORD_STAT(STAT_GameplayMessages_ThreadSafeQueueDepth, ThreadSafeMessageCount.load(std::memory_order_relaxed));
+
+	FThreadSafeMessage* Node = ThreadSafeMessageHead.exchange(nullptr, std::memory_order_acquire);
+	if (Node == nullptr)
+	{
+		return;
+	}
+
+	// The submission stack is newest first, reverse it to deliver in submission order
+	FThreadSafeMessage* OrderedHead = nullptr;
+	int32 NumTaken = 0;
+	while (Node != nullptr)
+	{
+		FThreadSafeMessage* Next = Node->Next;
+		Node->Next = OrderedHead;
+		OrderedHead = Node;
+		Node = Next;
+		++NumTaken;
+	}
+
+	ThreadSafeMessageCount.fetch_sub(NumTaken, std::memory_order_relaxed);
+
+	while (OrderedHead != nullptr)
+	{
+		FThreadSafeMessage* Next = OrderedHead->Next;
+		BroadcastMessageInternal(OrderedHead->Channel, OrderedHead->StructType, OrderedHead->Payload);
+		ReleaseThreadSafeMessage(OrderedHead);
+		OrderedHead = Next;
+	}
 }
 
 void UGameplayMessageSubsystem::K2_BroadcastMessage(FGameplayTag Channel, const int32& Message)
@@ -144,18 +797,22 @@ DEFINE_FUNCTION(UGameplayMessageSubsystem::execK2_BroadcastMessage)
 	}
 }
 
-FGameplayMessageListenerHandle UGameplayMessageSubsystem::RegisterListenerInternal(FGameplayTag Channel, TFunction<void(FGameplayTag, const UScriptStruct*, const void*)>&& Callback, const UScriptStruct* StructType, EGameplayMessageMatch MatchType)
+FGameplayMessageListenerHandle UGameplayMessageSubsystem::AddListenerToChannel(FGameplayTag Channel, int32 SlotIndex, const UScriptStruct* StructType, EGameplayMessageMatch MatchType)
 {
 	FChannelListenerList& List = ListenerMap.FindOrAdd(Channel);
 
-	FGameplayMessageListenerData& Entry = List.Listeners.AddDefaulted_GetRef();
-	Entry.ReceivedCallback = MoveTemp(Callback);
+	FListenerSlot& Slot = GetListenerSlot(SlotIndex);
+	Slot.Channel = Channel;
+	Slot.IndexInChannel = List.ListenerSlots.Add(SlotIndex);
+
+	FGameplayMessageListenerData& Entry = Slot.Data;
 	Entry.ListenerStructType = StructType;
 	Entry.bHadValidType = StructType != nullptr;
-	Entry.HandleID = ++List.HandleID;
 	Entry.MatchType = MatchType;
 
-	return FGameplayMessageListenerHandle(this, Channel, Entry.HandleID);
+	InvalidateDispatchTables(Channel, MatchType);
+
+	return FGameplayMessageListenerHandle(this, Channel, Slot.SlotGeneration, SlotIndex);
 }
 
 void UGameplayMessageSubsystem::UnregisterListener(FGameplayMessageListenerHandle Handle)
@@ -164,7 +821,7 @@ void UGameplayMessageSubsystem::UnregisterListener(FGameplayMessageListenerHandl
 	{
 		check(Handle.Subsystem == this);
 
-		UnregisterListenerInternal(Handle.Channel, Handle.ID);
+		UnregisterListenerInternal(Handle.SlotIndex, Handle.ID);
 	}
 	else
 	{
@@ -172,20 +829,143 @@ void UGameplayMessageSubsystem::UnregisterListener(FGameplayMessageListenerHandl
 	}
 }
 
-void UGameplayMessageSubsystem::UnregisterListenerInternal(FGameplayTag Channel, int32 HandleID)
+void UGameplayMessageSubsystem::UnregisterListenerInternal(int32 SlotIndex, int32 SlotGeneration)
 {
-	if (FChannelListenerList* pList = ListenerMap.Find(Channel))
+	if (!ensure(SlotIndex >= 0) || (SlotIndex >= NumListenerSlots))
 	{
-		int32 MatchIndex = pList->Listeners.IndexOfByPredicate([ID = HandleID](const FGameplayMessageListenerData& Other) { return Other.HandleID == ID; });
-		if (MatchIndex != INDEX_NONE)
+		return;
+	}
+
+	FListenerSlot& Slot = GetListenerSlot(SlotIndex);
+
+	// Stale handle, the listener was already removed (and the slot may have been reused since)
+	if (!Slot.bInUse || (Slot.SlotGeneration != SlotGeneration))
+	{
+		return;
+	}
+
+	if (FChannelListenerList* pList = ListenerMap.Find(Slot.Channel))
+	{
+		const int32 IndexInChannel = Slot.IndexInChannel;
+		pList->ListenerSlots.RemoveAtSwap(IndexInChannel, 1, EAllowShrinking::No);
+		if (pList->ListenerSlots.IsValidIndex(IndexInChannel))
 		{
-			pList->Listeners.RemoveAtSwap(MatchIndex);
+			GetListenerSlot(pList->ListenerSlots[IndexInChannel]).IndexInChannel = IndexInChannel;
 		}
 
-		if (pList->Listeners.Num() == 0)
+		if (pList->ListenerSlots.Num() == 0)
 		{
-			ListenerMap.Remove(Channel);
+			ListenerMap.Remove(Slot.Channel);
 		}
 	}
+
+	Slot.bInUse = false;
+	InvalidateDispatchTables(Slot.Channel, Slot.Data.MatchType);
+
+	// The callback may be the one currently executing, keep it alive until the broadcast unwinds
+	if (BroadcastDepth > 0)
+	{
+		PendingFreeListenerSlots.Add(SlotIndex);
+	}
+	else
+	{
+		FreeListenerSlot(SlotIndex);
+	}
 }
 
+int32 UGameplayMessageSubsystem::AllocateListenerSlot()
+{
+	int32 SlotIndex = FirstFreeListenerSlot;
+	if (SlotIndex != INDEX_NONE)
+	{
+		FirstFreeListenerSlot = GetListenerSlot(SlotIndex).NextFreeSlot;
+	}
+	else
+	{
+		SlotIndex = NumListenerSlots++;
+		if (SlotIndex / ListenerSlotsPerPage == ListenerSlotPages.Num())
+		{
+			ListenerSlotPages.Add(MakeUnique<FListenerSlot[]>(ListenerSlotsPerPage));
+		}
+	}
+
+	FListenerSlot& Slot = GetListenerSlot(SlotIndex);
+	Slot.bInUse = true;
+	Slot.NextFreeSlot = INDEX_NONE;
+
+	// Generation 0 is reserved for invalid handles
+	Slot.SlotGeneration = (Slot.SlotGeneration == MAX_int32) ? 1 : Slot.SlotGeneration + 1;
+
+	return SlotIndex;
+}
+
+void UGameplayMessageSubsystem::FreeListenerSlot(int32 SlotIndex)
+{
+	FListenerSlot& Slot = GetListenerSlot(SlotIndex);
+	check(!Slot.bInUse);
+
+	Slot.Data.ReceivedCallback.Reset();
+	Slot.Data.ListenerStructType.Reset();
+	Slot.Channel = FGameplayTag();
+	Slot.IndexInChannel = INDEX_NONE;
+
+	Slot.NextFreeSlot = FirstFreeListenerSlot;
+	FirstFreeListenerSlot = SlotIndex;
+}
+
+//////////////////////////////////////////////////////////////////////
+// UGameplayMessageSubsystem::FDeferredMessageArena
+
+UGameplayMessageSubsystem::FDeferredMessageArena::~FDeferredMessageArena()
+{
+	Empty();
+}
+
+void* UGameplayMessageSubsystem::FDeferredMessageArena::Allocate(int32 Size, int32 Alignment)
+{
+	if ((Size + Alignment > PageSize) || (Alignment > PageAlignment))
+	{
+		return OversizedAllocations.Add_GetRef(FMemory::Malloc(Size, Alignment));
+	}
+
+	while (true)
+	{
+		if (CurrentPage == Pages.Num())
+		{
+			Pages.Add(FMemory::Malloc(PageSize, PageAlignment));
+		}
+
+		const int32 AlignedOffset = Align(CurrentOffset, Alignment);
+		if (AlignedOffset + Size <= PageSize)
+		{
+			CurrentOffset = AlignedOffset + Size;
+			return static_cast<uint8*>(Pages[CurrentPage]) + AlignedOffset;
+		}
+
+		++CurrentPage;
+		CurrentOffset = 0;
+	}
+}
+
+void UGameplayMessageSubsystem::FDeferredMessageArena::Reset()
+{
+	for (void* Allocation : OversizedAllocations)
+	{
+		FMemory::Free(Allocation);
+	}
+	OversizedAllocations.Reset();
+
+	CurrentPage = 0;
+	CurrentOffset = 0;
+}
+
+void UGameplayMessageSubsystem::FDeferredMessageArena::Empty()
+{
+	Reset();
+
+	for (void* Page : Pages)
+	{
+		FMemory::Free(Page);
+	}
+	Pages.Empty();
+}
@@ -2,14 +2,22 @@
 
 #pragma once
 
+#include "Containers/LockFreeList.h"
+#include "Engine/EngineBaseTypes.h"
 #include "GameFramework/GameplayMessageTypes2.h"
 #include "GameplayTagContainer.h"
 #include "Subsystems/GameInstanceSubsystem.h"
+#include "Templates/PimplPtr.h"
 #include "UObject/WeakObjectPtr.h"
 
+#include <atomic>
+
 #include "GameplayMessageSubsystem.generated.h"
 
+class FGameplayMessageCaptureWriter;
+class FGameplayMessageReplay;
 class UGameplayMessageSubsystem;
+class UWorld;
 struct FFrame;
 
 GAMEPLAYMESSAGERUNTIME_API DECLARE_LOG_CATEGORY_EXTERN(LogGameplayMessageSubsystem, Log, All);
@@ -39,14 +47,79 @@ private:
 	UPROPERTY(Transient)
 	FGameplayTag Channel;
 
+	// Generation of the listener slot when this handle was issued, never 0 for a valid handle
 	UPROPERTY(Transient)
 	int32 ID = 0;
 
+	// Index of the listener slot in the subsystem
+	UPROPERTY(Transient)
+	int32 SlotIndex = INDEX_NONE;
+
 	FDelegateHandle StateClearedHandle;
 
 	friend UGameplayMessageSubsystem;
 
-	FGameplayMessageListenerHandle(UGameplayMessageSubsystem* InSubsystem, FGameplayTag InChannel, int32 InID) : Subsystem(InSubsystem), Channel(InChannel), ID(InID) {}
+	FGameplayMessageListenerHandle(UGameplayMessageSubsystem* InSubsystem, FGameplayTag InChannel, int32 InID, int32 InSlotIndex) : Subsystem(InSubsystem), Channel(InChannel), ID(InID), SlotIndex(InSlotIndex) {}
+};
+
+/**
+ * Type-erased listener callback with inline storage, so registering a typical listener does not touch the heap
+ * Callables that do not fit the inline buffer fall back to a heap allocation
+ */
+class FGameplayMessageListenerCallback
+{
+public:
+	FGameplayMessageListenerCallback() = default;
+	~FGameplayMessageListenerCallback() { Reset(); }
+
+	FGameplayMessageListenerCallback(const FGameplayMessageListenerCallback&) = delete;
+	FGameplayMessageListenerCallback& operator=(const FGameplayMessageListenerCallback&) = delete;
+
+	template <typename TCallable>
+	void Emplace(TCallable&& Callable)
+	{
+		typedef typename TDecay<TCallable>::Type FStoredType;
+
+		Reset();
+
+		const bool bFitsInline = (sizeof(FStoredType) <= InlineSize) && (alignof(FStoredType) <= InlineAlignment);
+		void* Storage = bFitsInline ? static_cast<void*>(InlineStorage) : FMemory::Malloc(sizeof(FStoredType), alignof(FStoredType));
+		new (Storage) FStoredType(Forward<TCallable>(Callable));
+
+		CallablePtr = Storage;
+		InvokeFunc = [](void* InCallable, FGameplayTag Channel, const UScriptStruct* StructType, const void* Payload) { (*static_cast<FStoredType*>(InCallable))(Channel, StructType, Payload); };
+		DestroyFunc = [](void* InCallable) { static_cast<FStoredType*>(InCallable)->~FStoredType(); };
+	}
+
+	void Reset()
+	{
+		if (CallablePtr != nullptr)
+		{
+			DestroyFunc(CallablePtr);
+			if (CallablePtr != InlineStorage)
+			{
+				FMemory::Free(CallablePtr);
+			}
+			CallablePtr = nullptr;
+		}
+	}
+
+	bool IsSet() const { return CallablePtr != nullptr; }
+
+	void operator()(FGameplayTag Channel, const UScriptStruct* StructType, const void* Payload) const
+	{
+		InvokeFunc(CallablePtr, Channel, StructType, Payload);
+	}
+
+private:
+	static constexpr int32 InlineSize = 64;
+	static constexpr int32 InlineAlignment = 16;
+
+	void* CallablePtr = nullptr;
+	void (*InvokeFunc)(void*, FGameplayTag, const UScriptStruct*, const void*) = nullptr;
+	void (*DestroyFunc)(void*) = nullptr;
+
+	alignas(InlineAlignment) uint8 InlineStorage[InlineSize];
 };
 
 /** 
@@ -58,16 +131,48 @@ struct FGameplayMessageListenerData
 	GENERATED_BODY()
 
 	// Callback for when a message has been received
-	TFunction<void(FGameplayTag, const UScriptStruct*, const void*)> ReceivedCallback;
+	FGameplayMessageListenerCallback ReceivedCallback;
 
-	int32 HandleID;
-	EGameplayMessageMatch MatchType;
+	EGameplayMessageMatch MatchType = EGameplayMessageMatch::ExactMatch;
 
 	// Adding some logging and extra variables around some potential problems with this
 	TWeakObjectPtr<const UScriptStruct> ListenerStructType = nullptr;
 	bool bHadValidType = false;
 };
 
+template<>
+struct TStructOpsTypeTraits<FGameplayMessageListenerData> : public TStructOpsTypeTraitsBase2<FGameplayMessageListenerData>
+{
+	enum
+	{
+		WithCopy = false,
+	};
+};
+
+/**
+ * Counters for a single channel, collected while GameplayMessageSubsystem.CollectStats is enabled
+ * @see UGameplayMessageSubsystem::GetChannelStats
+ */
+struct FGameplayMessageChannelStats
+{
+	uint64 NumBroadcasts = 0;
+	uint64 NumDeliveries = 0;
+	uint64 NumTypeMismatches = 0;
+
+	// Time spent inside listener callbacks, in FPlatformTime cycles
+	uint64 TotalCallbackCycles = 0;
+	uint64 MaxCallbackCycles = 0;
+
+	// Number of listeners that received the most recent broadcast (including partial matches on parent channels)
+	int32 NumListeners = 0;
+
+	// Broadcast rate measured over the last completed one second window
+	float BroadcastsPerSecond = 0.0f;
+
+	int32 NumBroadcastsThisFrame = 0;
+	int32 NumBroadcastsThisWindow = 0;
+};
+
 /**
  * This system allows event raisers and listeners to register for messages without
  * having to know about each other directly, though they must agree on the format
@@ -102,9 +207,12 @@ public:
 	static bool HasInstance(const UObject* WorldContextObject);
 
 	//~USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
 	virtual void Deinitialize() override;
 	//~End of USubsystem interface
 
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
 	/**
 	 * Broadcast a message on the specified channel
 	 *
@@ -118,6 +226,55 @@ public:
 		BroadcastMessageInternal(Channel, StructType, &Message);
 	}
 
+	/**
+	 * Queue a message to be broadcast on the specified channel once the world has finished ticking actors this frame
+	 * Messages are delivered in the order they were queued; a message queued while the queue is being flushed is delivered next frame
+	 *
+	 * @param Channel			The message channel to broadcast on
+	 * @param Message			The message to send (copied, so it does not need to outlive this call)
+	 * @param CoalescingKey		If non-zero, a message already pending on the same channel with the same type and key is merged
+	 *							with this one (see TGameplayMessageCoalescingTraits) instead of being delivered separately
+	 */
+	template <typename FMessageStructType>
+	void BroadcastMessageDeferred(FGameplayTag Channel, const FMessageStructType& Message, uint64 CoalescingKey = 0)
+	{
+		const UScriptStruct* StructType = TBaseStructure<FMessageStructType>::Get();
+		BroadcastMessageDeferredInternal(Channel, StructType, &Message, CoalescingKey, &MergeDeferredMessage<FMessageStructType>);
+	}
+
+	/**
+	 * Queue a message from any thread, to be broadcast on the game thread after the world has finished ticking actors
+	 * The payload is copied into a pooled buffer; callers are responsible for keeping any objects it references alive until delivery
+	 *
+	 * @param Channel			The message channel to broadcast on
+	 * @param Message			The message to send (copied, so it does not need to outlive this call)
+	 */
+	template <typename FMessageStructType>
+	void BroadcastMessageFromAnyThread(FGameplayTag Channel, const FMessageStructType& Message)
+	{
+		static_assert(alignof(FMessageStructType) <= FThreadSafeMessage::InlinePayloadAlignment, "Message type is over-aligned for the thread safe message pool");
+
+		FThreadSafeMessage* Node = AllocateThreadSafeMessage(sizeof(FMessageStructType));
+		Node->Channel = Channel;
+		Node->StructType = TBaseStructure<FMessageStructType>::Get();
+		Node->DestroyPayload = [](void* Payload) { static_cast<FMessageStructType*>(Payload)->~FMessageStructType(); };
+		new (Node->Payload) FMessageStructType(Message);
+
+		SubmitThreadSafeMessage(Node);
+	}
+
+	/** Broadcast every message queued with BroadcastMessageFromAnyThread (game thread only, normally done automatically after actors have ticked) */
+	void DrainThreadSafeMessages();
+
+	/** @return the number of messages queued with BroadcastMessageFromAnyThread that have not been delivered yet */
+	int32 GetThreadSafeQueueDepth() const { return ThreadSafeMessageCount.load(std::memory_order_relaxed); }
+
+	/**
+	 * Immediately broadcast every message queued with BroadcastMessageDeferred
+	 * This normally happens automatically after actors have ticked
+	 */
+	void FlushDeferredMessages();
+
 	/**
 	 * Register to receive messages on a specified channel
 	 *
@@ -135,7 +292,7 @@ public:
 		};
 
 		const UScriptStruct* StructType = TBaseStructure<FMessageStructType>::Get();
-		return RegisterListenerInternal(Channel, ThunkCallback, StructType, MatchType);
+		return RegisterListenerInternal(Channel, MoveTemp(ThunkCallback), StructType, MatchType);
 	}
 
 	/**
@@ -151,15 +308,18 @@ public:
 	template <typename FMessageStructType, typename TOwner = UObject>
 	FGameplayMessageListenerHandle RegisterListener(FGameplayTag Channel, TOwner* Object, void(TOwner::* Function)(FGameplayTag, const FMessageStructType&))
 	{
+		// Bound directly rather than through the TFunction overload so the whole thunk fits in the listener's inline storage
 		TWeakObjectPtr<TOwner> WeakObject(Object);
-		return RegisterListener<FMessageStructType>(Channel,
-			[WeakObject, Function](FGameplayTag Channel, const FMessageStructType& Payload)
+		auto ThunkCallback = [WeakObject, Function](FGameplayTag ActualTag, const UScriptStruct* SenderStructType, const void* SenderPayload)
+		{
+			if (TOwner* StrongObject = WeakObject.Get())
 			{
-				if (TOwner* StrongObject = WeakObject.Get())
-				{
-					(StrongObject->*Function)(Channel, Payload);
-				}
-			});
+				(StrongObject->*Function)(ActualTag, *reinterpret_cast<const FMessageStructType*>(SenderPayload));
+			}
+		};
+
+		const UScriptStruct* StructType = TBaseStructure<FMessageStructType>::Get();
+		return RegisterListenerInternal(Channel, MoveTemp(ThunkCallback), StructType, EGameplayMessageMatch::ExactMatch);
 	}
 
 	/**
@@ -185,12 +345,50 @@ public:
 			};
 
 			const UScriptStruct* StructType = TBaseStructure<FMessageStructType>::Get();
-			Handle = RegisterListenerInternal(Channel, ThunkCallback, StructType, Params.MatchType);
+			Handle = RegisterListenerInternal(Channel, MoveTemp(ThunkCallback), StructType, Params.MatchType);
 		}
 
 		return Handle;
 	}
 
+	/** @return per-channel counters collected while GameplayMessageSubsystem.CollectStats is enabled */
+	const TMap<FGameplayTag, FGameplayMessageChannelStats>& GetChannelStats() const { return ChannelStats; }
+
+	/** Clears all collected channel counters */
+	void ResetChannelStats();
+
+	/** Writes a table of the collected channel counters, most expensive channels first */
+	void DumpChannelStats(FOutputDevice& Ar) const;
+
+	/**
+	 * Start streaming every broadcast to a binary capture file, written on a background thread
+	 * Not available while a replay is running, the replayed messages would end up in the capture
+	 *
+	 * @param Filename			File to write, defaults to a timestamped file in the profiling directory
+	 * @return true if the file could be opened
+	 */
+	bool StartMessageCapture(const FString& Filename = FString());
+
+	/** Stop a capture started by StartMessageCapture and close the file */
+	void StopMessageCapture();
+
+	bool IsCapturingMessages() const { return CaptureWriter.IsValid(); }
+
+	/**
+	 * Re-broadcast the messages from a capture file with their original relative timing
+	 * Not available while a capture is running, the replayed messages would end up in the capture
+	 *
+	 * @param Filename			Capture file written by StartMessageCapture
+	 * @param PlaybackRate		Speed multiplier for the original timing, 0 delivers everything on the next tick
+	 * @return true if the file could be loaded
+	 */
+	bool StartMessageReplay(const FString& Filename, float PlaybackRate = 1.0f);
+
+	/** Stop a replay started by StartMessageReplay */
+	void StopMessageReplay();
+
+	bool IsReplayingMessages() const { return Replay.IsValid(); }
+
 	/**
 	 * Remove a message listener previously registered by RegisterListener
 	 *
@@ -214,23 +412,249 @@ private:
 	// Internal helper for broadcasting a message
 	void BroadcastMessageInternal(FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes);
 
+	typedef void (*FDeferredMessageMergeFunc)(void* PendingMessage, const void* NewMessage);
+
+	template <typename FMessageStructType>
+	static void MergeDeferredMessage(void* PendingMessage, const void* NewMessage)
+	{
+		TGameplayMessageCoalescingTraits<FMessageStructType>::Merge(*static_cast<FMessageStructType*>(PendingMessage), *static_cast<const FMessageStructType*>(NewMessage));
+	}
+
+	// Internal helper for queuing a deferred message
+	void BroadcastMessageDeferredInternal(FGameplayTag Channel, const UScriptStruct* StructType, const void* MessageBytes, uint64 CoalescingKey, FDeferredMessageMergeFunc MergeFunc);
+
+	void HandleWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	// Publishes this frame's channel counters to the CSV profiler and rolls the broadcast rate window
+	void UpdateChannelStats();
+
+	// A message submitted from an arbitrary thread, nodes and their payload buffers are pooled
+	struct FThreadSafeMessage
+	{
+		static constexpr int32 InlinePayloadSize = 256;
+		static constexpr int32 InlinePayloadAlignment = 16;
+
+		FThreadSafeMessage* Next = nullptr;
+		FGameplayTag Channel;
+		const UScriptStruct* StructType = nullptr;
+		void (*DestroyPayload)(void* Payload) = nullptr;
+
+		// Points at InlinePayload unless the message was too large to fit
+		void* Payload = nullptr;
+
+		alignas(InlinePayloadAlignment) uint8 InlinePayload[InlinePayloadSize];
+	};
+
+	// Grabs a node from the pool (thread safe)
+	FThreadSafeMessage* AllocateThreadSafeMessage(int32 PayloadSize);
+
+	// Pushes a node onto the submission queue (thread safe)
+	void SubmitThreadSafeMessage(FThreadSafeMessage* Node);
+
+	// Destroys the payload and returns the node to the pool
+	void ReleaseThreadSafeMessage(FThreadSafeMessage* Node);
+
 	// Internal helper for registering a message listener
+	template <typename TCallable>
 	FGameplayMessageListenerHandle RegisterListenerInternal(
 		FGameplayTag Channel, 
-		TFunction<void(FGameplayTag, const UScriptStruct*, const void*)>&& Callback,
+		TCallable&& Callback,
 		const UScriptStruct* StructType,
-		EGameplayMessageMatch MatchType);
+		EGameplayMessageMatch MatchType)
+	{
+		const int32 SlotIndex = AllocateListenerSlot();
+		GetListenerSlot(SlotIndex).Data.ReceivedCallback.Emplace(Forward<TCallable>(Callback));
+		return AddListenerToChannel(Channel, SlotIndex, StructType, MatchType);
+	}
+
+	// Fills in an allocated slot and links it into the channel's listener list
+	FGameplayMessageListenerHandle AddListenerToChannel(FGameplayTag Channel, int32 SlotIndex, const UScriptStruct* StructType, EGameplayMessageMatch MatchType);
 
-	void UnregisterListenerInternal(FGameplayTag Channel, int32 HandleID);
+	void UnregisterListenerInternal(int32 SlotIndex, int32 SlotGeneration);
 
 private:
+	// Storage for a single registered listener, slots live in fixed pages so their addresses never change
+	struct FListenerSlot
+	{
+		FGameplayMessageListenerData Data;
+		FGameplayTag Channel;
+
+		// Incremented every time the slot is handed out, handles and dispatch entries remember the value they saw
+		int32 SlotGeneration = 0;
+
+		// Position of this slot in its channel's listener list (or the next free slot while unused)
+		int32 IndexInChannel = INDEX_NONE;
+		int32 NextFreeSlot = INDEX_NONE;
+
+		bool bInUse = false;
+	};
+
+	static constexpr int32 ListenerSlotsPerPage = 64;
+
+	FListenerSlot& GetListenerSlot(int32 SlotIndex)
+	{
+		return ListenerSlotPages[SlotIndex / ListenerSlotsPerPage][SlotIndex % ListenerSlotsPerPage];
+	}
+
+	int32 AllocateListenerSlot();
+	void FreeListenerSlot(int32 SlotIndex);
+
 	// List of all entries for a given channel
 	struct FChannelListenerList
 	{
-		TArray<FGameplayMessageListenerData> Listeners;
-		int32 HandleID = 0;
+		TArray<int32> ListenerSlots;
+	};
+
+	// Flattened list of every listener that receives a broadcast on a given channel
+	// (exact matches on the channel itself plus partial matches on all of its ancestors)
+	struct FChannelDispatchTable
+	{
+		struct FEntry
+		{
+			int32 SlotIndex;
+			int32 SlotGeneration;
+		};
+
+		// Which entries can receive a given broadcast struct type, computed the first time that type is broadcast on the channel
+		struct FStructCompatibility
+		{
+			const UScriptStruct* BroadcastStructType = nullptr;
+
+			// Only checked after garbage collection, a new struct may have been allocated at the address of an unloaded one
+			TWeakObjectPtr<const UScriptStruct> BroadcastStructTypeWeak;
+
+			// One bit per entry, set if the listener accepts the broadcast type
+			TBitArray<> CompatibleEntries;
+
+			// Entries expecting an unrelated type (reported on every broadcast)
+			TArray<int32> MismatchedEntries;
+
+			// Entries whose expected type has been unloaded (removed on the next broadcast)
+			TArray<int32> StaleEntries;
+		};
+
+		TArray<FEntry> Entries;
+
+		// Heap allocated so references stay valid while a nested broadcast adds another struct type
+		mutable TArray<TUniquePtr<FStructCompatibility>> CompatibilityCache;
+
+		// Cached so Insights events do not need to convert the tag to a string on every broadcast
+		FString TraceEventName;
+
+		// Set when the listeners of the channel (or a parent channel) changed, the next broadcast builds a new table while
+		// broadcasts in flight keep using this one
+		mutable bool bStale = false;
+	};
+
+	// Returns the dispatch table for a channel, rebuilding it if listeners changed since it was built
+	TSharedRef<const FChannelDispatchTable> GetDispatchTable(FGameplayTag Channel);
+
+	// Returns which entries of a dispatch table accept the given struct type, computing it on first use
+	const FChannelDispatchTable::FStructCompatibility& GetStructCompatibility(const FChannelDispatchTable& DispatchTable, const UScriptStruct* StructType);
+
+	// Marks the dispatch tables a listener registered on Channel with MatchType is part of for rebuilding
+	// (only the channel's own table for exact matches, the tables of all its child channels as well for partial matches)
+	void InvalidateDispatchTables(FGameplayTag Channel, EGameplayMessageMatch MatchType);
+
+	// Forces every dispatch table to be rebuilt (e.g. after struct types were reloaded)
+	void InvalidateAllDispatchTables();
+
+	// Marks the dispatch tables that reference an unloaded struct type for rebuilding
+	void HandlePostGarbageCollect();
+
+	// Paged bump allocator for deferred message payloads, pages are kept around and reused every frame
+	struct FDeferredMessageArena
+	{
+		~FDeferredMessageArena();
+
+		void* Allocate(int32 Size, int32 Alignment);
+
+		// Releases every allocation at once (payloads must already have been destroyed)
+		void Reset();
+
+		// Frees all pages
+		void Empty();
+
+	private:
+		static constexpr int32 PageSize = 16 * 1024;
+		static constexpr int32 PageAlignment = 16;
+
+		TArray<void*> Pages;
+		TArray<void*> OversizedAllocations;
+		int32 CurrentPage = 0;
+		int32 CurrentOffset = 0;
+	};
+
+	// A message waiting to be delivered by FlushDeferredMessages
+	struct FDeferredMessage
+	{
+		FGameplayTag Channel;
+		const UScriptStruct* StructType = nullptr;
+		void* Payload = nullptr;
+	};
+
+	// Identifies pending deferred messages that should be merged together
+	struct FDeferredMessageKey
+	{
+		FGameplayTag Channel;
+		const UScriptStruct* StructType = nullptr;
+		uint64 CoalescingKey = 0;
+
+		bool operator==(const FDeferredMessageKey& Other) const
+		{
+			return (Channel == Other.Channel) && (StructType == Other.StructType) && (CoalescingKey == Other.CoalescingKey);
+		}
+
+		friend uint32 GetTypeHash(const FDeferredMessageKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.Channel), GetTypeHash(Key.StructType)), GetTypeHash(Key.CoalescingKey));
+		}
 	};
 
 private:
 	TMap<FGameplayTag, FChannelListenerList> ListenerMap;
+
+	// Lazily built dispatch tables, shared so a broadcast in flight keeps its table alive across re-entrant changes
+	TMap<FGameplayTag, TSharedRef<const FChannelDispatchTable>> DispatchTables;
+
+	// Paged listener storage with an intrusive free list
+	TArray<TUniquePtr<FListenerSlot[]>> ListenerSlotPages;
+	int32 NumListenerSlots = 0;
+	int32 FirstFreeListenerSlot = INDEX_NONE;
+
+	// Slots unregistered during a broadcast, their callbacks may still be executing so they are freed once it finishes
+	TArray<int32> PendingFreeListenerSlots;
+	int32 BroadcastDepth = 0;
+
+	// Messages queued by BroadcastMessageDeferred, in delivery order
+	TArray<FDeferredMessage> DeferredMessages;
+
+	// Index into DeferredMessages of each pending message that can be coalesced
+	TMap<FDeferredMessageKey, int32> DeferredMessageIndices;
+
+	// Payload storage, double buffered so messages queued during a flush land in the other arena
+	FDeferredMessageArena DeferredMessageArenas[2];
+	int32 ActiveDeferredMessageArena = 0;
+
+	// Head of the lock-free multi-producer submission stack, the game thread takes the whole list at once
+	std::atomic<FThreadSafeMessage*> ThreadSafeMessageHead{ nullptr };
+	std::atomic<int32> ThreadSafeMessageCount{ 0 };
+
+	// Recycled submission nodes
+	TLockFreePointerListUnordered<FThreadSafeMessage, PLATFORM_CACHE_LINE_SIZE> ThreadSafeMessagePool;
+
+	// Profiling counters per broadcast channel
+	TMap<FGameplayTag, FGameplayMessageChannelStats> ChannelStats;
+	double ChannelStatsStartTime = 0.0;
+	double ChannelStatsWindowStartTime = 0.0;
+
+	// Active capture/replay, if any
+	TPimplPtr<FGameplayMessageCaptureWriter> CaptureWriter;
+	TPimplPtr<FGameplayMessageReplay> Replay;
+
+	FDelegateHandle PostActorTickHandle;
+	FDelegateHandle PostGarbageCollectHandle;
+#if WITH_RELOAD
+	FDelegateHandle ReloadCompleteHandle;
+#endif
 };
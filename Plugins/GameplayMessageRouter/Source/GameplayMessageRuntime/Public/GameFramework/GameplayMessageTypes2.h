@@ -48,3 +48,17 @@ struct FGameplayMessageListenerParams
 		};
 	}
 };
+
+/**
+ * Controls how a deferred message is folded into a pending message with the same coalescing key
+ * By default the newer message replaces the pending one, specialize this for message types that carry deltas
+ * @see UGameplayMessageSubsystem::BroadcastMessageDeferred
+ */
+template<typename FMessageStructType>
+struct TGameplayMessageCoalescingTraits
+{
+	static void Merge(FMessageStructType& PendingMessage, const FMessageStructType& NewMessage)
+	{
+		PendingMessage = NewMessage;
+	}
+};
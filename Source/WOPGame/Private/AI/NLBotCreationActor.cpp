@@ -36,6 +36,12 @@ void ANLBotCreationActor::BeginPlay()
 #endif
 }
 
+void ANLBotCreationActor::SetBotCreationEntries(const TArray<FNLBotCreationEntry>& InBotCreationEntries, float InZoneRadius)
+{
+	BotCreationEntries = InBotCreationEntries;
+	ZoneRadius = InZoneRadius;
+}
+
 #if WITH_SERVER_CODE
 void ANLBotCreationActor::ServerCreateBots()
 {
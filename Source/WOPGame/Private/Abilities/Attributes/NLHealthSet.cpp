@@ -8,6 +8,7 @@
 #include "Engine/World.h"
 #include "GameplayEffectExtension.h"
 #include "GameFramework/GameplayMessageSubsystem.h"
+#include "NLStats.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(NLHealthSet)
 
@@ -17,6 +18,8 @@ UE_DEFINE_GAMEPLAY_TAG(TAG_Gameplay_DamageSelfDestruct, "Gameplay.Damage.SelfDes
 UE_DEFINE_GAMEPLAY_TAG(TAG_Gameplay_FellOutOfWorld, "Gameplay.Damage.FellOutOfWorld");
 UE_DEFINE_GAMEPLAY_TAG(TAG_NL_Damage_Message, "NL.Damage.Message");
 
+DECLARE_CYCLE_STAT(TEXT("NLHealthSet PostGameplayEffectExecute"), STAT_NLHealthSet_PostGameplayEffectExecute, STATGROUP_WOPGame);
+
 UNLHealthSet::UNLHealthSet()
 	: Health(100.0f)
 	, MaxHealth(100.0f)
@@ -96,6 +99,8 @@ bool UNLHealthSet::PreGameplayEffectExecute(FGameplayEffectModCallbackData &Data
 
 void UNLHealthSet::PostGameplayEffectExecute(const FGameplayEffectModCallbackData& Data)
 {
+	NL_SCOPE_CYCLE_COUNTER(STAT_NLHealthSet_PostGameplayEffectExecute);
+
 	Super::PostGameplayEffectExecute(Data);
 
 	const bool bIsDamageFromSelfDestruct = Data.EffectSpec.GetDynamicAssetTags().HasTagExact(TAG_Gameplay_DamageSelfDestruct);
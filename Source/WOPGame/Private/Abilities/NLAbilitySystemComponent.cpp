@@ -7,6 +7,7 @@
 #include "GameFramework/Pawn.h"
 #include "Abilities/NLGlobalAbilitySystem.h"
 #include "NLLogChannels.h"
+#include "NLStats.h"
 #include "System/NLAssetManager.h"
 #include "System/NLGameData.h"
 
@@ -14,6 +15,8 @@
 
 UE_DEFINE_GAMEPLAY_TAG(TAG_Gameplay_AbilityInputBlocked, "Gameplay.AbilityInputBlocked");
 
+DECLARE_CYCLE_STAT(TEXT("NLAbilitySystemComponent ProcessAbilityInput"), STAT_NLAbilitySystemComponent_ProcessAbilityInput, STATGROUP_WOPGame);
+
 
 UNLAbilitySystemComponent::UNLAbilitySystemComponent(const FObjectInitializer& ObjectInitializer)
     : Super(ObjectInitializer)
@@ -186,6 +189,8 @@ void UNLAbilitySystemComponent::AbilityInputTagReleased(const FGameplayTag& Inpu
 
 void UNLAbilitySystemComponent::ProcessAbilityInput(float DeltaTime, bool bGamePaused)
 {
+    NL_SCOPE_CYCLE_COUNTER(STAT_NLAbilitySystemComponent_ProcessAbilityInput);
+
     if (HasMatchingGameplayTag(TAG_Gameplay_AbilityInputBlocked)) {
         ClearAbilityInput();
         return;
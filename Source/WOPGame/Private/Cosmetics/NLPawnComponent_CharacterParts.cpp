@@ -7,6 +7,7 @@
 #include "GameFramework/Character.h"
 #include "GameplayTagAssetInterface.h"
 #include "Net/UnrealNetwork.h"
+#include "NLStats.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(NLPawnComponent_CharacterParts)
 
@@ -15,6 +16,9 @@ class UPhysicsAsset;
 class USkeletalMesh;
 class UWorld;
 
+DECLARE_CYCLE_STAT(TEXT("NLCharacterPartList SpawnActorForEntry"), STAT_NLCharacterPartList_SpawnActorForEntry, STATGROUP_WOPGame);
+DECLARE_CYCLE_STAT(TEXT("NLCharacterPartList DestroyActorForEntry"), STAT_NLCharacterPartList_DestroyActorForEntry, STATGROUP_WOPGame);
+
 //////////////////////////////////////////////////////////////////////
 
 FString FNLAppliedCharacterPartEntry::GetDebugString() const
@@ -152,6 +156,8 @@ FGameplayTagContainer FNLCharacterPartList::CollectCombinedTags() const
 
 bool FNLCharacterPartList::SpawnActorForEntry(FNLAppliedCharacterPartEntry& Entry)
 {
+	NL_SCOPE_CYCLE_COUNTER(STAT_NLCharacterPartList_SpawnActorForEntry);
+
 	bool bCreatedAnyActors = false;
 
 	if (ensure(OwnerComponent) && !OwnerComponent->IsNetMode(NM_DedicatedServer))
@@ -201,6 +207,8 @@ bool FNLCharacterPartList::SpawnActorForEntry(FNLAppliedCharacterPartEntry& Entr
 
 bool FNLCharacterPartList::DestroyActorForEntry(FNLAppliedCharacterPartEntry& Entry)
 {
+	NL_SCOPE_CYCLE_COUNTER(STAT_NLCharacterPartList_DestroyActorForEntry);
+
 	bool bDestroyedAnyActors = false;
 
 	if (Entry.SpawnedComponent != nullptr)
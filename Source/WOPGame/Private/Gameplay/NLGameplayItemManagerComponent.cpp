@@ -9,6 +9,7 @@
 #include "Engine/ActorChannel.h"
 #include "Engine/World.h"
 #include "GameFramework/GameplayMessageSubsystem.h"
+#include "NLStats.h"
 #include "NativeGameplayTags.h"
 #include "Net/UnrealNetwork.h"
 
@@ -16,6 +17,12 @@
 
 UE_DEFINE_GAMEPLAY_TAG_STATIC(TAG_NL_GameplayItem_Message_StackChanged, "NL.GameplayItem.StackChanged.Message");
 
+DECLARE_CYCLE_STAT(TEXT("NLGameplayItemList AddEntry"), STAT_NLGameplayItemList_AddEntry, STATGROUP_WOPGame);
+DECLARE_CYCLE_STAT(TEXT("NLGameplayItemList RemoveEntry"), STAT_NLGameplayItemList_RemoveEntry, STATGROUP_WOPGame);
+DECLARE_CYCLE_STAT(TEXT("NLGameplayItemManager AddItemDefinition"), STAT_NLGameplayItemManager_AddItemDefinition, STATGROUP_WOPGame);
+DECLARE_CYCLE_STAT(TEXT("NLGameplayItemManager RemoveItemInstance"), STAT_NLGameplayItemManager_RemoveItemInstance, STATGROUP_WOPGame);
+DECLARE_CYCLE_STAT(TEXT("NLGameplayItemManager ConsumeItemsByDefinition"), STAT_NLGameplayItemManager_ConsumeItemsByDefinition, STATGROUP_WOPGame);
+
 //////////////////////////////////////////////////////////////////////
 // FNLGameplayItemEntry
 
@@ -72,12 +79,17 @@ void FNLGameplayItemList::BroadcastChangeMessage(FNLGameplayItemEntry& Entry, in
 	Message.NewCount = NewCount;
 	Message.Delta = NewCount - OldCount;
 
+	// Bursts of adds/removes on the same instance collapse into one message per frame
+	const uint64 CoalescingKey = (Entry.Instance != nullptr) ? ((uint64(OwnerComponent->GetUniqueID()) << 32) | uint32(Entry.Instance->GetUniqueID())) : 0;
+
 	UGameplayMessageSubsystem& MessageSystem = UGameplayMessageSubsystem::Get(OwnerComponent->GetWorld());
-	MessageSystem.BroadcastMessage(TAG_NL_GameplayItem_Message_StackChanged, Message);
+	MessageSystem.BroadcastMessageDeferred(TAG_NL_GameplayItem_Message_StackChanged, Message, CoalescingKey);
 }
 
 UNLGameplayItemInstance* FNLGameplayItemList::AddEntry(TSubclassOf<UNLGameplayItemDefinition> ItemDef, int32 StackCount)
 {
+	NL_DETAILED_SCOPE_CYCLE_COUNTER(STAT_NLGameplayItemList_AddEntry);
+
 	UNLGameplayItemInstance* Result = nullptr;
 
 	check(ItemDef != nullptr);
@@ -111,6 +123,8 @@ UNLGameplayItemInstance* FNLGameplayItemList::AddEntry(TSubclassOf<UNLGameplayIt
 
 void FNLGameplayItemList::RemoveEntry(UNLGameplayItemInstance* Instance)
 {
+	NL_DETAILED_SCOPE_CYCLE_COUNTER(STAT_NLGameplayItemList_RemoveEntry);
+
     AActor* OwningActor = OwnerComponent->GetOwner();
     check(OwningActor->HasAuthority());
 
@@ -178,6 +192,8 @@ bool UNLGameplayItemManagerComponent::CanAddItemDefinition(TSubclassOf<UNLGamepl
 
 UNLGameplayItemInstance* UNLGameplayItemManagerComponent::AddItemDefinition(TSubclassOf<UNLGameplayItemDefinition> ItemDef, int32 StackCount)
 {
+	NL_SCOPE_CYCLE_COUNTER(STAT_NLGameplayItemManager_AddItemDefinition);
+
 	UNLGameplayItemInstance* Result = nullptr;
 
     if (ItemDef == nullptr || !CanAddItemDefinition(ItemDef, StackCount)) {
@@ -228,6 +244,8 @@ UNLGameplayItemInstance* UNLGameplayItemManagerComponent::AddItemDefinition(TSub
 
 void UNLGameplayItemManagerComponent::RemoveItemInstance(UNLGameplayItemInstance* ItemInstance)
 {
+	NL_SCOPE_CYCLE_COUNTER(STAT_NLGameplayItemManager_RemoveItemInstance);
+
     UNLApplicableGameplayItemManagerComponent* ApplicableGameplayItemManager = FindApplicableGameplayItemManager();
 	UNLGameplaySubsystem* NLGameplaySubsystem = UWorld::GetSubsystem<UNLGameplaySubsystem>(GetOwner()->GetWorld());
 
@@ -290,6 +308,8 @@ int32 UNLGameplayItemManagerComponent::GetTotalItemCountByDefinition(TSubclassOf
 
 bool UNLGameplayItemManagerComponent::ConsumeItemsByDefinition(TSubclassOf<UNLGameplayItemDefinition> ItemDef, int32 NumToConsume)
 {
+	NL_SCOPE_CYCLE_COUNTER(STAT_NLGameplayItemManager_ConsumeItemsByDefinition);
+
 	AActor* OwningActor = GetOwner();
 	if (!OwningActor || !OwningActor->HasAuthority())
 	{
@@ -10,11 +10,14 @@
 #include "Interaction/InteractionOption.h"
 #include "Interaction/InteractionQuery.h"
 #include "Interaction/InteractionStatics.h"
+#include "NLStats.h"
 #include "Physics/NLCollisionChannels.h"
 #include "TimerManager.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(AbilityTask_GrantNearbyInteraction)
 
+DECLARE_CYCLE_STAT(TEXT("GrantNearbyInteraction QueryInteractables"), STAT_GrantNearbyInteraction_QueryInteractables, STATGROUP_WOPGame);
+
 UAbilityTask_GrantNearbyInteraction::UAbilityTask_GrantNearbyInteraction(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
@@ -48,6 +51,8 @@ void UAbilityTask_GrantNearbyInteraction::OnDestroy(bool AbilityEnded)
 
 void UAbilityTask_GrantNearbyInteraction::QueryInteractables()
 {
+	NL_SCOPE_CYCLE_COUNTER(STAT_GrantNearbyInteraction_QueryInteractables);
+
 	UWorld* World = GetWorld();
 	AActor* ActorOwner = GetAvatarActor();
 	
@@ -6,9 +6,12 @@
 #include "Engine/World.h"
 #include "GameFramework/PlayerController.h"
 #include "Interaction/IInteractableTarget.h"
+#include "NLStats.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(AbilityTask_WaitForInteractableTargets)
 
+DECLARE_CYCLE_STAT(TEXT("WaitForInteractableTargets UpdateInteractableOptions"), STAT_WaitForInteractableTargets_UpdateInteractableOptions, STATGROUP_WOPGame);
+
 struct FInteractionQuery;
 
 UAbilityTask_WaitForInteractableTargets::UAbilityTask_WaitForInteractableTargets(const FObjectInitializer& ObjectInitializer)
@@ -106,6 +109,8 @@ bool UAbilityTask_WaitForInteractableTargets::ClipCameraRayToAbilityRange(FVecto
 
 void UAbilityTask_WaitForInteractableTargets::UpdateInteractableOptions(const FInteractionQuery& InteractQuery, const TArray<TScriptInterface<IInteractableTarget>>& InteractableTargets)
 {
+	NL_DETAILED_SCOPE_CYCLE_COUNTER(STAT_WaitForInteractableTargets_UpdateInteractableOptions);
+
 	TArray<FInteractionOption> NewOptions;
 
 	for (const TScriptInterface<IInteractableTarget>& InteractiveTarget : InteractableTargets)
@@ -2,12 +2,15 @@
 
 #include "Interaction/Tasks/AbilityTask_WaitForInteractableTargets_SingleLineTrace.h"
 #include "Interaction/InteractionStatics.h"
+#include "NLStats.h"
 #include "DrawDebugHelpers.h"
 #include "Engine/World.h"
 #include "TimerManager.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(AbilityTask_WaitForInteractableTargets_SingleLineTrace)
 
+DECLARE_CYCLE_STAT(TEXT("WaitForInteractableTargets PerformTrace"), STAT_WaitForInteractableTargets_PerformTrace, STATGROUP_WOPGame);
+
 UAbilityTask_WaitForInteractableTargets_SingleLineTrace::UAbilityTask_WaitForInteractableTargets_SingleLineTrace(const FObjectInitializer& ObjectInitializer)
 	: Super(ObjectInitializer)
 {
@@ -46,6 +49,8 @@ void UAbilityTask_WaitForInteractableTargets_SingleLineTrace::OnDestroy(bool Abi
 
 void UAbilityTask_WaitForInteractableTargets_SingleLineTrace::PerformTrace()
 {
+	NL_SCOPE_CYCLE_COUNTER(STAT_WaitForInteractableTargets_PerformTrace);
+
 	AActor* AvatarActor = Ability->GetCurrentActorInfo()->AvatarActor.Get();
 	if (!AvatarActor)
 	{
@@ -7,6 +7,8 @@
 #include "GameFramework/PlayerState.h"
 #include "GameplayEffectTypes.h"
 #include "Messages/NLVerbMessage.h"
+#include "Player/NLPlayerState.h"
+#include "UObject/CoreNet.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(NLVerbMessageHelpers)
 
@@ -20,6 +22,177 @@ FString FNLVerbMessage::ToString() const
 	return HumanReadableMessage;
 }
 
+//////////////////////////////////////////////////////////////////////
+// FNLVerbMessageBatch
+
+namespace NLVerbMessageBatch
+{
+	// Set when a field matches the previous message in the batch and is omitted
+	enum ESameAsPreviousFlags : uint8
+	{
+		SameVerb = 1 << 0,
+		SameInstigator = 1 << 1,
+		SameTarget = 1 << 2,
+		SameInstigatorTags = 1 << 3,
+		SameTargetTags = 1 << 4,
+		SameContextTags = 1 << 5,
+	};
+	static constexpr uint32 NumSameAsPreviousBits = 6;
+
+	enum class EMagnitudeEncoding : uint8
+	{
+		SameAsPrevious = 0,
+		WholeNumber = 1,
+		Float = 2,
+	};
+	static constexpr uint32 NumMagnitudeEncodingBits = 2;
+
+	// Whole magnitudes in this range are sent as zigzag packed ints, everything else is quantized to a float
+	static constexpr double MaxWholeNumberMagnitude = double(1 << 30);
+
+	// Objects the receiving side can't resolve yet (e.g., actors that aren't relevant to it) clear bOutAllMapped, that is not an error
+	static void SerializeObject(FArchive& Ar, UPackageMap* Map, TObjectPtr<UObject>& Object, bool& bOutAllMapped)
+	{
+		UObject* RawObject = Object;
+		bOutAllMapped &= Map->SerializeObject(Ar, UObject::StaticClass(), RawObject);
+		if (Ar.IsLoading())
+		{
+			Object = RawObject;
+		}
+	}
+}
+
+bool FNLVerbMessageBatch::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	using namespace NLVerbMessageBatch;
+
+	bOutSuccess = true;
+	bool bAllObjectsMapped = true;
+
+	uint32 NumMessages = Messages.Num();
+	Ar.SerializeIntPacked(NumMessages);
+
+	if (Ar.IsLoading())
+	{
+		if (NumMessages > uint32(MaxMessages))
+		{
+			Ar.SetError();
+			bOutSuccess = false;
+			return false;
+		}
+
+		Messages.Reset();
+		Messages.SetNum(NumMessages);
+	}
+
+	const FNLVerbMessage DefaultMessage;
+	const FNLVerbMessage* Previous = &DefaultMessage;
+
+	for (FNLVerbMessage& Message : Messages)
+	{
+		uint8 SameAsPrevious = 0;
+		uint8 MagnitudeEncoding = uint8(EMagnitudeEncoding::Float);
+
+		if (Ar.IsSaving())
+		{
+			SameAsPrevious |= (Message.Verb == Previous->Verb) ? SameVerb : 0;
+			SameAsPrevious |= (Message.Instigator == Previous->Instigator) ? SameInstigator : 0;
+			SameAsPrevious |= (Message.Target == Previous->Target) ? SameTarget : 0;
+			SameAsPrevious |= (Message.InstigatorTags == Previous->InstigatorTags) ? SameInstigatorTags : 0;
+			SameAsPrevious |= (Message.TargetTags == Previous->TargetTags) ? SameTargetTags : 0;
+			SameAsPrevious |= (Message.ContextTags == Previous->ContextTags) ? SameContextTags : 0;
+
+			if (Message.Magnitude == Previous->Magnitude)
+			{
+				MagnitudeEncoding = uint8(EMagnitudeEncoding::SameAsPrevious);
+			}
+			else if ((FMath::RoundToDouble(Message.Magnitude) == Message.Magnitude) && (FMath::Abs(Message.Magnitude) < MaxWholeNumberMagnitude))
+			{
+				MagnitudeEncoding = uint8(EMagnitudeEncoding::WholeNumber);
+			}
+		}
+
+		Ar.SerializeBits(&SameAsPrevious, NumSameAsPreviousBits);
+		Ar.SerializeBits(&MagnitudeEncoding, NumMagnitudeEncodingBits);
+
+		// Copies the field from the previous message when it was omitted, serializes it otherwise
+		auto SerializeField = [&](uint8 SameFlag, auto&& CopyFromPrevious, auto&& SerializeValue)
+		{
+			if (SameAsPrevious & SameFlag)
+			{
+				CopyFromPrevious();
+			}
+			else
+			{
+				bool bFieldSuccess = true;
+				SerializeValue(bFieldSuccess);
+				bOutSuccess &= bFieldSuccess;
+			}
+		};
+
+		SerializeField(SameVerb,
+			[&]() { Message.Verb = Previous->Verb; },
+			[&](bool& bFieldSuccess) { Message.Verb.NetSerialize(Ar, Map, bFieldSuccess); });
+		SerializeField(SameInstigator,
+			[&]() { Message.Instigator = Previous->Instigator; },
+			[&](bool& bFieldSuccess) { SerializeObject(Ar, Map, Message.Instigator, bAllObjectsMapped); });
+		SerializeField(SameTarget,
+			[&]() { Message.Target = Previous->Target; },
+			[&](bool& bFieldSuccess) { SerializeObject(Ar, Map, Message.Target, bAllObjectsMapped); });
+		SerializeField(SameInstigatorTags,
+			[&]() { Message.InstigatorTags = Previous->InstigatorTags; },
+			[&](bool& bFieldSuccess) { Message.InstigatorTags.NetSerialize(Ar, Map, bFieldSuccess); });
+		SerializeField(SameTargetTags,
+			[&]() { Message.TargetTags = Previous->TargetTags; },
+			[&](bool& bFieldSuccess) { Message.TargetTags.NetSerialize(Ar, Map, bFieldSuccess); });
+		SerializeField(SameContextTags,
+			[&]() { Message.ContextTags = Previous->ContextTags; },
+			[&](bool& bFieldSuccess) { Message.ContextTags.NetSerialize(Ar, Map, bFieldSuccess); });
+
+		switch (EMagnitudeEncoding(MagnitudeEncoding))
+		{
+		case EMagnitudeEncoding::SameAsPrevious:
+			Message.Magnitude = Previous->Magnitude;
+			break;
+
+		case EMagnitudeEncoding::WholeNumber:
+		{
+			int32 WholeMagnitude = int32(Message.Magnitude);
+			uint32 ZigZag = (uint32(WholeMagnitude) << 1) ^ uint32(WholeMagnitude >> 31);
+			Ar.SerializeIntPacked(ZigZag);
+			if (Ar.IsLoading())
+			{
+				Message.Magnitude = double(int32(ZigZag >> 1) ^ -int32(ZigZag & 1));
+			}
+			break;
+		}
+
+		case EMagnitudeEncoding::Float:
+		{
+			float QuantizedMagnitude = float(Message.Magnitude);
+			Ar << QuantizedMagnitude;
+			Message.Magnitude = QuantizedMagnitude;
+			break;
+		}
+
+		default:
+			Ar.SetError();
+			break;
+		}
+
+		if (Ar.IsError())
+		{
+			bOutSuccess = false;
+			return false;
+		}
+
+		Previous = &Message;
+	}
+
+	// Following the engine convention, the return value reports whether every object reference could be mapped
+	return bAllObjectsMapped;
+}
+
 //////////////////////////////////////////////////////////////////////
 // 
 
@@ -95,3 +268,32 @@ FNLVerbMessage UNLVerbMessageHelpers::CueParametersToVerbMessage(const FGameplay
 	return Result;
 }
 
+void UNLVerbMessageHelpers::QueueMessageForInvolvedPlayers(const FNLVerbMessage& Message, bool bOnlyIfRelevant)
+{
+	// Damage causers are often weapons or projectiles, those belong to the player of their instigator
+	auto FindPlayerState = [](UObject* Object) -> ANLPlayerState*
+	{
+		if (APlayerState* PS = GetPlayerStateFromObject(Object))
+		{
+			return Cast<ANLPlayerState>(PS);
+		}
+		if (const AActor* Actor = Cast<AActor>(Object))
+		{
+			return Cast<ANLPlayerState>(GetPlayerStateFromObject(Actor->GetInstigator()));
+		}
+		return nullptr;
+	};
+
+	ANLPlayerState* InstigatorPS = FindPlayerState(Message.Instigator);
+	ANLPlayerState* TargetPS = FindPlayerState(Message.Target);
+
+	if ((InstigatorPS != nullptr) && InstigatorPS->HasAuthority())
+	{
+		InstigatorPS->QueueClientMessage(Message, bOnlyIfRelevant);
+	}
+
+	if ((TargetPS != nullptr) && (TargetPS != InstigatorPS) && TargetPS->HasAuthority())
+	{
+		TargetPS->QueueClientMessage(Message, bOnlyIfRelevant);
+	}
+}
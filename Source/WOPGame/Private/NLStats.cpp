@@ -0,0 +1,20 @@
+// Copyright 2025 Noblon GmbH. All Rights Reserved.
+
+#include "NLStats.h"
+#include "HAL/IConsoleManager.h"
+
+CSV_DEFINE_CATEGORY_MODULE(WOPGAME_API, WOPGame, true);
+
+#if NL_STATS_ENABLED
+
+namespace NLStats
+{
+	bool bDetailedScopes = false;
+	static FAutoConsoleVariableRef CVarDetailedScopes(
+		TEXT("NL.Stats.DetailedScopes"),
+		bDetailedScopes,
+		TEXT("Enables the fine grained WOPGame stat, CSV and trace scopes (per item, per team lookup, per interaction option, ...)."),
+		ECVF_Default);
+}
+
+#endif // NL_STATS_ENABLED
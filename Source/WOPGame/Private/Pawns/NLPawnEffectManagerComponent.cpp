@@ -266,8 +266,11 @@ void UNLPawnEffectManagerComponent::BroadcastChangeMessage(FActiveGameplayEffect
     Message.PreviousStackCount = PreviousStackCount;
     Message.Delta = NewStackCount - PreviousStackCount;
 
+    // Several stack changes of the same effect within a frame collapse into one message
+    const uint64 CoalescingKey = (uint64(Pawn->GetUniqueID()) << 32) | GetTypeHash(EffectHandle);
+
     UGameplayMessageSubsystem& MessageSystem = UGameplayMessageSubsystem::Get(Pawn->GetWorld());
-    MessageSystem.BroadcastMessage(TAG_NL_PawnEffect_Message_StackChanged, Message);
+    MessageSystem.BroadcastMessageDeferred(TAG_NL_PawnEffect_Message_StackChanged, Message, CoalescingKey);
 }
 
 TArray<FActiveGameplayEffectHandle> UNLPawnEffectManagerComponent::GetPawnGameplayEffectHandles() const
@@ -0,0 +1,514 @@
+// Copyright 2025 Noblon GmbH. All Rights Reserved.
+
+#include "Performance/NLHitchCapture.h"
+
+#if NL_HITCH_CAPTURE_ENABLED
+
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "GameFramework/GameplayMessageSubsystem.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTLS.h"
+#include "HAL/ThreadManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "NLLogChannels.h"
+#include "Tasks/Task.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace NLHitchCapture
+{
+	// Opt-in for Shipping, where the scopes then only cost a branch
+	bool bEnabled = !UE_BUILD_SHIPPING;
+	static FAutoConsoleVariableRef CVarEnabled(
+		TEXT("NL.HitchCapture"),
+		bEnabled,
+		TEXT("Records WOPGame scopes, garbage collections and package loads into per-thread ring buffers and writes the recent history to <ProfilingDir>/Hitches when a frame goes over NL.HitchCapture.BudgetMS. Off by default in Shipping."),
+		ECVF_Default);
+
+	static float BudgetMS = 100.0f;
+	static FAutoConsoleVariableRef CVarBudgetMS(
+		TEXT("NL.HitchCapture.BudgetMS"),
+		BudgetMS,
+		TEXT("Frames taking longer than this (in milliseconds) trigger a hitch capture. 0 disables automatic captures."),
+		ECVF_Default);
+
+	static int32 NumFramesToCapture = 30;
+	static FAutoConsoleVariableRef CVarNumFramesToCapture(
+		TEXT("NL.HitchCapture.NumFrames"),
+		NumFramesToCapture,
+		TEXT("How many frames (including the hitch) a hitch capture covers, at most 127."),
+		ECVF_Default);
+
+	static float MinCaptureInterval = 60.0f;
+	static FAutoConsoleVariableRef CVarMinCaptureInterval(
+		TEXT("NL.HitchCapture.MinInterval"),
+		MinCaptureInterval,
+		TEXT("Minimum time (in seconds) between two hitch captures."),
+		ECVF_Default);
+
+	static int32 MaxCapturesPerSession = 10;
+	static FAutoConsoleVariableRef CVarMaxCapturesPerSession(
+		TEXT("NL.HitchCapture.MaxPerSession"),
+		MaxCapturesPerSession,
+		TEXT("Maximum number of hitch captures written per game instance, negative for no limit."),
+		ECVF_Default);
+
+	static bool bCaptureRequested = false;
+	static FAutoConsoleCommand CmdCaptureNow(
+		TEXT("NL.HitchCapture.CaptureNow"),
+		TEXT("Writes a hitch capture at the end of the current frame, regardless of the budget and rate limit."),
+		FConsoleCommandDelegate::CreateLambda([]() { bCaptureRequested = true; }));
+
+	// Names of the events that don't come from WOPGame scopes, compared by pointer to categorize them
+	static const TCHAR* GarbageCollectEventName = TEXT("GarbageCollect");
+	static const TCHAR* LoadPackageEventName = TEXT("LoadPackage");
+	static const TCHAR* SyncLoadPackageEventName = TEXT("SyncLoadPackage");
+
+	struct FTimingEvent
+	{
+		const TCHAR* Name = nullptr;
+		FName Detail;
+		uint64 StartCycles = 0;
+		uint64 EndCycles = 0;
+	};
+
+	// Written only by its owning thread, read by captures on the game thread
+	struct FThreadBuffer
+	{
+		static constexpr uint64 Capacity = 4096;
+
+		FTimingEvent Events[Capacity];
+		std::atomic<uint64> NumWritten{ 0 };
+		uint32 ThreadId = 0;
+		FString ThreadName;
+	};
+
+	// Buffers live until the process exits, so a thread going away never invalidates what a capture is reading
+	struct FThreadBufferRegistry
+	{
+		FCriticalSection Lock;
+		TArray<FThreadBuffer*> Buffers;
+
+		static FThreadBufferRegistry& Get()
+		{
+			static FThreadBufferRegistry* Registry = new FThreadBufferRegistry();
+			return *Registry;
+		}
+	};
+
+	static FThreadBuffer* CreateThreadBuffer()
+	{
+		FThreadBuffer* Buffer = new FThreadBuffer();
+		Buffer->ThreadId = FPlatformTLS::GetCurrentThreadId();
+		Buffer->ThreadName = IsInGameThread() ? FString(TEXT("GameThread")) : FThreadManager::GetThreadName(Buffer->ThreadId);
+		if (Buffer->ThreadName.IsEmpty())
+		{
+			Buffer->ThreadName = FString::Printf(TEXT("Thread %u"), Buffer->ThreadId);
+		}
+
+		FThreadBufferRegistry& Registry = FThreadBufferRegistry::Get();
+		FScopeLock Lock(&Registry.Lock);
+		Registry.Buffers.Add(Buffer);
+		return Buffer;
+	}
+
+	void RecordEvent(const TCHAR* Name, uint64 StartCycles, uint64 EndCycles, FName Detail)
+	{
+		static thread_local FThreadBuffer* Buffer = nullptr;
+		if (Buffer == nullptr)
+		{
+			Buffer = CreateThreadBuffer();
+		}
+
+		const uint64 Index = Buffer->NumWritten.load(std::memory_order_relaxed);
+		FTimingEvent& Event = Buffer->Events[Index % FThreadBuffer::Capacity];
+		Event.Name = Name;
+		Event.Detail = Detail;
+		Event.StartCycles = StartCycles;
+		Event.EndCycles = EndCycles;
+		Buffer->NumWritten.store(Index + 1, std::memory_order_release);
+	}
+
+	struct FCapturedThread
+	{
+		uint32 ThreadId = 0;
+		FString ThreadName;
+		TArray<FTimingEvent> Events;
+	};
+
+	// Copies the events that ended after SinceCycles out of every thread's ring buffer
+	static void CopyEvents(uint64 SinceCycles, TArray<FCapturedThread>& OutThreads)
+	{
+		FThreadBufferRegistry& Registry = FThreadBufferRegistry::Get();
+		FScopeLock Lock(&Registry.Lock);
+
+		for (const FThreadBuffer* Buffer : Registry.Buffers)
+		{
+			const uint64 End = Buffer->NumWritten.load(std::memory_order_acquire);
+			const uint64 Begin = (End > FThreadBuffer::Capacity) ? (End - FThreadBuffer::Capacity) : 0;
+
+			TArray<FTimingEvent> Events;
+			Events.Reserve(int32(End - Begin));
+			for (uint64 Index = Begin; Index < End; ++Index)
+			{
+				Events.Add(Buffer->Events[Index % FThreadBuffer::Capacity]);
+			}
+
+			// Other threads keep writing while we copy, drop whatever they may have overwritten in the meantime, including the
+			// slot of a write that is still in progress (it is published only once NumWritten moves past it)
+			const uint64 EndAfterCopy = Buffer->NumWritten.load(std::memory_order_acquire);
+			const uint64 FirstValid = (EndAfterCopy + 1 > FThreadBuffer::Capacity) ? (EndAfterCopy + 1 - FThreadBuffer::Capacity) : 0;
+			if (FirstValid > Begin)
+			{
+				Events.RemoveAt(0, FMath::Min(int32(FirstValid - Begin), Events.Num()));
+			}
+
+			Events.RemoveAll([SinceCycles](const FTimingEvent& Event) { return Event.EndCycles < SinceCycles; });
+			if (Events.Num() > 0)
+			{
+				FCapturedThread& Thread = OutThreads.AddDefaulted_GetRef();
+				Thread.ThreadId = Buffer->ThreadId;
+				Thread.ThreadName = Buffer->ThreadName;
+				Thread.Events = MoveTemp(Events);
+			}
+		}
+	}
+
+	void SumScopeTimes(uint64 SinceCycles, uint64 UntilCycles, TMap<const TCHAR*, double>& InOutScopeMS)
+	{
+		FThreadBufferRegistry& Registry = FThreadBufferRegistry::Get();
+		FScopeLock Lock(&Registry.Lock);
+
+		for (const FThreadBuffer* Buffer : Registry.Buffers)
+		{
+			// Scopes are recorded in the order they end, so walk back from the newest event until they get too old instead of
+			// copying the whole buffer
+			const uint64 End = Buffer->NumWritten.load(std::memory_order_acquire);
+			for (uint64 Index = End; Index > 0; --Index)
+			{
+				const FTimingEvent Event = Buffer->Events[(Index - 1) % FThreadBuffer::Capacity];
+
+				// Stop once the owning thread may have overwritten the slot, see CopyEvents
+				const uint64 Written = Buffer->NumWritten.load(std::memory_order_acquire);
+				if (Written + 1 > Index - 1 + FThreadBuffer::Capacity)
+				{
+					break;
+				}
+
+				if (Event.EndCycles < SinceCycles)
+				{
+					break;
+				}
+
+				const bool bIsScope = (Event.Name != GarbageCollectEventName) && (Event.Name != LoadPackageEventName) && (Event.Name != SyncLoadPackageEventName);
+				if (bIsScope && (Event.EndCycles < UntilCycles))
+				{
+					InOutScopeMS.FindOrAdd(Event.Name) += FPlatformTime::ToMilliseconds64(Event.EndCycles - Event.StartCycles);
+				}
+			}
+		}
+	}
+
+	// Message traffic of one channel over the captured frames
+	struct FCapturedChannel
+	{
+		FString Channel;
+		uint64 NumBroadcasts = 0;
+		uint64 NumDeliveries = 0;
+		uint64 CallbackCycles = 0;
+		uint32 MaxBroadcastsInFrame = 0;
+	};
+
+	static FString EscapeJson(FString Text)
+	{
+		return Text.ReplaceCharWithEscapedChar();
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// FNLHitchCapture
+
+FNLHitchCapture::FNLHitchCapture()
+	: bWriteInFlight(MakeShared<std::atomic<bool>>(false))
+{
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddRaw(this, &FNLHitchCapture::HandlePreGarbageCollect);
+	FCoreUObjectDelegates::GetPostGarbageCollect().AddRaw(this, &FNLHitchCapture::HandlePostGarbageCollect);
+	FCoreUObjectDelegates::OnEndLoadPackage.AddRaw(this, &FNLHitchCapture::HandleEndLoadPackage);
+}
+
+FNLHitchCapture::~FNLHitchCapture()
+{
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().RemoveAll(this);
+	FCoreUObjectDelegates::GetPostGarbageCollect().RemoveAll(this);
+	FCoreUObjectDelegates::OnEndLoadPackage.RemoveAll(this);
+}
+
+void FNLHitchCapture::HandlePreGarbageCollect()
+{
+	GarbageCollectStartCycles = FPlatformTime::Cycles64();
+}
+
+void FNLHitchCapture::HandlePostGarbageCollect()
+{
+	if (NLHitchCapture::bEnabled && (GarbageCollectStartCycles != 0))
+	{
+		NLHitchCapture::RecordEvent(NLHitchCapture::GarbageCollectEventName, GarbageCollectStartCycles, FPlatformTime::Cycles64());
+	}
+	GarbageCollectStartCycles = 0;
+}
+
+void FNLHitchCapture::HandleEndLoadPackage(const FEndLoadPackageContext& Context)
+{
+	if (!NLHitchCapture::bEnabled)
+	{
+		return;
+	}
+
+	// Only the end of the load is known here, so loads show up as instant events
+	const TCHAR* EventName = Context.bSynchronous ? NLHitchCapture::SyncLoadPackageEventName : NLHitchCapture::LoadPackageEventName;
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+	for (const UPackage* Package : Context.LoadedPackages)
+	{
+		if (Package != nullptr)
+		{
+			NLHitchCapture::RecordEvent(EventName, NowCycles, NowCycles, Package->GetFName());
+		}
+	}
+}
+
+void FNLHitchCapture::ProcessFrame(const IPerformanceDataConsumer::FFrameData& FrameData, const UGameInstance* GameInstance)
+{
+	FFrameRecord& Frame = Frames[NumFrames % MaxFrames];
+	Frame.FrameNumber = GFrameCounter;
+	Frame.EndCycles = FPlatformTime::Cycles64();
+	Frame.FrameTime = (float)FrameData.TrueDeltaSeconds;
+	Frame.GameThreadTime = (float)FrameData.GameThreadTimeSeconds;
+	Frame.RenderThreadTime = (float)FrameData.RenderThreadTimeSeconds;
+	Frame.RHIThreadTime = (float)FrameData.RHIThreadTimeSeconds;
+	Frame.GPUTime = (float)FrameData.GPUTimeSeconds;
+	RecordMessageDeltas(Frame, GameInstance);
+	++NumFrames;
+
+	if (ShouldCapture(Frame))
+	{
+		Capture(GameInstance);
+	}
+}
+
+void FNLHitchCapture::RecordMessageDeltas(FFrameRecord& Frame, const UGameInstance* GameInstance)
+{
+	Frame.MessageDeltas.Reset();
+
+	if (!NLHitchCapture::bEnabled)
+	{
+		return;
+	}
+
+	// The router only counts per-channel traffic while its stats are collected, which costs it on every broadcast, so the
+	// message traffic is only part of the capture when someone opted into that
+	if (CVarCollectMessageStats == nullptr)
+	{
+		CVarCollectMessageStats = IConsoleManager::Get().FindConsoleVariable(TEXT("GameplayMessageSubsystem.CollectStats"));
+	}
+	if ((CVarCollectMessageStats == nullptr) || !CVarCollectMessageStats->GetBool())
+	{
+		return;
+	}
+
+	const UGameplayMessageSubsystem* MessageSubsystem = GameInstance ? GameInstance->GetSubsystem<UGameplayMessageSubsystem>() : nullptr;
+	if (MessageSubsystem == nullptr)
+	{
+		return;
+	}
+
+	for (const TPair<FGameplayTag, FGameplayMessageChannelStats>& Pair : MessageSubsystem->GetChannelStats())
+	{
+		const FGameplayMessageChannelStats& Stats = Pair.Value;
+		FChannelTotals& Totals = LastChannelTotals.FindOrAdd(Pair.Key);
+
+		// The counters only go down when the router's stats were reset, everything since then is new
+		if (Stats.NumBroadcasts < Totals.NumBroadcasts)
+		{
+			Totals = FChannelTotals();
+		}
+
+		if (Stats.NumBroadcasts != Totals.NumBroadcasts)
+		{
+			FChannelFrameDelta& Delta = Frame.MessageDeltas.AddDefaulted_GetRef();
+			Delta.Channel = Pair.Key;
+			Delta.NumBroadcasts = uint32(Stats.NumBroadcasts - Totals.NumBroadcasts);
+			Delta.NumDeliveries = uint32(Stats.NumDeliveries - FMath::Min(Totals.NumDeliveries, Stats.NumDeliveries));
+			Delta.CallbackCycles = Stats.TotalCallbackCycles - FMath::Min(Totals.CallbackCycles, Stats.TotalCallbackCycles);
+
+			Totals.NumBroadcasts = Stats.NumBroadcasts;
+			Totals.NumDeliveries = Stats.NumDeliveries;
+			Totals.CallbackCycles = Stats.TotalCallbackCycles;
+		}
+	}
+}
+
+bool FNLHitchCapture::ShouldCapture(const FFrameRecord& Frame) const
+{
+	if (!NLHitchCapture::bEnabled || bWriteInFlight->load())
+	{
+		return false;
+	}
+
+	if (NLHitchCapture::bCaptureRequested)
+	{
+		return true;
+	}
+
+	if ((NLHitchCapture::BudgetMS <= 0.0f) || (Frame.FrameTime * 1000.0f <= NLHitchCapture::BudgetMS))
+	{
+		return false;
+	}
+
+	if ((NLHitchCapture::MaxCapturesPerSession >= 0) && (NumCaptures >= NLHitchCapture::MaxCapturesPerSession))
+	{
+		return false;
+	}
+
+	return (NumCaptures == 0) || (FPlatformTime::Seconds() - LastCaptureTime >= NLHitchCapture::MinCaptureInterval);
+}
+
+void FNLHitchCapture::Capture(const UGameInstance* GameInstance)
+{
+	using namespace NLHitchCapture;
+
+	bCaptureRequested = false;
+	LastCaptureTime = FPlatformTime::Seconds();
+	++NumCaptures;
+
+	// The frames covered by the capture, oldest first
+	const int32 NumCapturedFrames = (int32)FMath::Min<uint64>(NumFrames, FMath::Clamp(NumFramesToCapture, 1, MaxFrames - 1));
+	TArray<FFrameRecord> CapturedFrames;
+	CapturedFrames.Reserve(NumCapturedFrames);
+	for (uint64 Index = NumFrames - NumCapturedFrames; Index < NumFrames; ++Index)
+	{
+		CapturedFrames.Add(Frames[Index % MaxFrames]);
+	}
+
+	// The window starts where the frame before the oldest captured one ended
+	const FFrameRecord& OldestFrame = CapturedFrames[0];
+	const uint64 WindowStartCycles = (NumFrames > (uint64)NumCapturedFrames)
+		? Frames[(NumFrames - NumCapturedFrames - 1) % MaxFrames].EndCycles
+		: OldestFrame.EndCycles - uint64(OldestFrame.FrameTime / FPlatformTime::GetSecondsPerCycle64());
+
+	TArray<FCapturedThread> CapturedThreads;
+	CopyEvents(WindowStartCycles, CapturedThreads);
+
+	// Message traffic summed over the captured frames
+	TMap<FGameplayTag, FCapturedChannel> ChannelTraffic;
+	for (const FFrameRecord& Frame : CapturedFrames)
+	{
+		for (const FChannelFrameDelta& Delta : Frame.MessageDeltas)
+		{
+			FCapturedChannel& Channel = ChannelTraffic.FindOrAdd(Delta.Channel);
+			Channel.NumBroadcasts += Delta.NumBroadcasts;
+			Channel.NumDeliveries += Delta.NumDeliveries;
+			Channel.CallbackCycles += Delta.CallbackCycles;
+			Channel.MaxBroadcastsInFrame = FMath::Max(Channel.MaxBroadcastsInFrame, Delta.NumBroadcasts);
+		}
+	}
+
+	TArray<FCapturedChannel> CapturedChannels;
+	CapturedChannels.Reserve(ChannelTraffic.Num());
+	for (TPair<FGameplayTag, FCapturedChannel>& Pair : ChannelTraffic)
+	{
+		Pair.Value.Channel = Pair.Key.ToString();
+		CapturedChannels.Add(MoveTemp(Pair.Value));
+	}
+	CapturedChannels.Sort([](const FCapturedChannel& A, const FCapturedChannel& B) { return A.CallbackCycles > B.CallbackCycles; });
+
+	const UWorld* World = GameInstance ? GameInstance->GetWorld() : nullptr;
+	const FFrameRecord& HitchFrame = CapturedFrames.Last();
+	const FString MapName = World ? World->GetMapName() : FString();
+	const FString Filename = FPaths::ProfilingDir() / TEXT("Hitches") / FString::Printf(TEXT("Hitch_%s_%s_%llu.json"),
+		IsRunningDedicatedServer() ? TEXT("Server") : TEXT("Client"), *FDateTime::Now().ToString(), HitchFrame.FrameNumber);
+
+	UE_LOG(LogNL, Log, TEXT("Frame %llu took %.1f ms, writing hitch capture of %d frames to %s"), HitchFrame.FrameNumber, HitchFrame.FrameTime * 1000.0f, NumCapturedFrames, *Filename);
+
+	// Formatting and writing is the expensive part, keep it off the game thread
+	bWriteInFlight->store(true);
+	UE::Tasks::Launch(UE_SOURCE_LOCATION,
+		[bWriteInFlight = bWriteInFlight, CapturedFrames = MoveTemp(CapturedFrames), CapturedThreads = MoveTemp(CapturedThreads), CapturedChannels = MoveTemp(CapturedChannels), MapName, Filename, WindowStartCycles]()
+	{
+		const double MicrosecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1000000.0;
+		auto ToTimestamp = [WindowStartCycles, MicrosecondsPerCycle](uint64 Cycles)
+		{
+			return (Cycles >= WindowStartCycles) ? double(Cycles - WindowStartCycles) * MicrosecondsPerCycle : 0.0;
+		};
+
+		const FFrameRecord& LastFrame = CapturedFrames.Last();
+
+		FString Json;
+		Json.Reserve(256 * 1024);
+		Json += TEXT("{\n");
+		Json += FString::Printf(TEXT("\"otherData\":{\"map\":\"%s\",\"dateTime\":\"%s\",\"server\":%s,\"frameNumber\":%llu,\"frameTimeMs\":%.3f,\"budgetMs\":%.3f},\n"),
+			*EscapeJson(MapName), *FDateTime::UtcNow().ToIso8601(), IsRunningDedicatedServer() ? TEXT("true") : TEXT("false"), LastFrame.FrameNumber, LastFrame.FrameTime * 1000.0f, BudgetMS);
+
+		Json += TEXT("\"messageChannels\":[");
+		for (int32 Index = 0; Index < CapturedChannels.Num(); ++Index)
+		{
+			const FCapturedChannel& Channel = CapturedChannels[Index];
+			Json += FString::Printf(TEXT("%s\n{\"channel\":\"%s\",\"broadcasts\":%llu,\"deliveries\":%llu,\"maxBroadcastsInFrame\":%u,\"callbackMs\":%.4f}"),
+				(Index > 0) ? TEXT(",") : TEXT(""), *EscapeJson(Channel.Channel), Channel.NumBroadcasts, Channel.NumDeliveries, Channel.MaxBroadcastsInFrame, FPlatformTime::ToMilliseconds64(Channel.CallbackCycles));
+		}
+		Json += TEXT("],\n");
+
+		// Chrome trace events, the frames go on their own track (tid 0)
+		Json += TEXT("\"displayTimeUnit\":\"ms\",\n\"traceEvents\":[\n");
+		Json += TEXT("{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"Frames\"}}");
+
+		uint64 FrameStartCycles = WindowStartCycles;
+		for (const FFrameRecord& Frame : CapturedFrames)
+		{
+			uint32 NumMessageBroadcasts = 0;
+			for (const FChannelFrameDelta& Delta : Frame.MessageDeltas)
+			{
+				NumMessageBroadcasts += Delta.NumBroadcasts;
+			}
+
+			Json += FString::Printf(TEXT(",\n{\"ph\":\"X\",\"name\":\"Frame %llu\",\"cat\":\"Frame\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"frameMs\":%.3f,\"gameThreadMs\":%.3f,\"renderThreadMs\":%.3f,\"rhiThreadMs\":%.3f,\"gpuMs\":%.3f,\"messageBroadcasts\":%u}}"),
+				Frame.FrameNumber, ToTimestamp(FrameStartCycles), ToTimestamp(Frame.EndCycles) - ToTimestamp(FrameStartCycles),
+				Frame.FrameTime * 1000.0f, Frame.GameThreadTime * 1000.0f, Frame.RenderThreadTime * 1000.0f, Frame.RHIThreadTime * 1000.0f, Frame.GPUTime * 1000.0f, NumMessageBroadcasts);
+			FrameStartCycles = Frame.EndCycles;
+		}
+
+		for (const FCapturedThread& Thread : CapturedThreads)
+		{
+			Json += FString::Printf(TEXT(",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}"), Thread.ThreadId, *EscapeJson(Thread.ThreadName));
+
+			for (const FTimingEvent& Event : Thread.Events)
+			{
+				if ((Event.Name == LoadPackageEventName) || (Event.Name == SyncLoadPackageEventName))
+				{
+					Json += FString::Printf(TEXT(",\n{\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s\",\"cat\":\"Loading\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"args\":{\"package\":\"%s\"}}"),
+						Event.Name, Thread.ThreadId, ToTimestamp(Event.EndCycles), *EscapeJson(Event.Detail.ToString()));
+				}
+				else
+				{
+					// WOPGame scopes are named after their cycle stat
+					const TCHAR* Name = (FCString::Strncmp(Event.Name, TEXT("STAT_"), 5) == 0) ? (Event.Name + 5) : Event.Name;
+					const TCHAR* Category = (Event.Name == GarbageCollectEventName) ? TEXT("GC") : TEXT("WOPGame");
+					Json += FString::Printf(TEXT(",\n{\"ph\":\"X\",\"name\":\"%s\",\"cat\":\"%s\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}"),
+						Name, Category, Thread.ThreadId, ToTimestamp(Event.StartCycles), ToTimestamp(Event.EndCycles) - ToTimestamp(Event.StartCycles));
+				}
+			}
+		}
+		Json += TEXT("\n]\n}\n");
+
+		if (!FFileHelper::SaveStringToFile(Json, *Filename, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM))
+		{
+			UE_LOG(LogNL, Warning, TEXT("Failed to write hitch capture %s"), *Filename);
+		}
+
+		bWriteInFlight->store(false);
+	});
+}
+
+#endif // NL_HITCH_CAPTURE_ENABLED
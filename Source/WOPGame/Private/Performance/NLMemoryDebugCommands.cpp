@@ -3,8 +3,13 @@
 #include "Engine/BlueprintGeneratedClass.h"
 #include "UObject/UObjectIterator.h"
 #include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
 #include "Engine/World.h"
+#include "Containers/Ticker.h"
+#include "Tasks/Task.h"
+
+#include <atomic>
 
 #include "NLLogChannels.h"
 
@@ -154,3 +159,302 @@ void AnalyzeObjectListForDifferences(TArrayView<UObject*> ObjectList, UClass* Co
 
 //////////////////////////////////////////////////////////////////////////
 
+// Memory sampler
+//
+// A sample walks the object list on the game thread and only records each object's class, package and sizes, the
+// aggregation per class and per outer package and the file writing happen on a background task.
+// Snapshots are CSV files in <ProfilingDir>/MemSnapshots that NL.MemDiff compares.
+
+#if ALLOW_DEBUG_FILES
+
+namespace NLMemorySampler
+{
+	struct FObjectRecord
+	{
+		FName ClassName;
+		FName PackageName;
+		int64 ObjectBytes = 0;
+		int64 ResourceBytes = 0;
+	};
+
+	struct FSnapshotEntry
+	{
+		int64 Count = 0;
+		int64 ObjectBytes = 0;
+		int64 ResourceBytes = 0;
+
+		int64 GetTotalBytes() const { return ObjectBytes + ResourceBytes; }
+	};
+
+	// Aggregated snapshot, keyed by class and by outer package
+	struct FSnapshot
+	{
+		TMap<FName, FSnapshotEntry> Classes;
+		TMap<FName, FSnapshotEntry> Packages;
+	};
+
+	static float SampleInterval = 0.0f;
+	static bool bIncludeResourceSize = true;
+	static std::atomic<bool> bSampleInFlight{ false };
+	static FTSTicker::FDelegateHandle SampleTickerHandle;
+
+	static FString GetSnapshotDir()
+	{
+		return FPaths::ProfilingDir() / TEXT("MemSnapshots");
+	}
+
+	static void WriteSnapshot(const FString& Filename, const FString& Context, const FSnapshot& Snapshot)
+	{
+		TStringBuilder<16384> Text;
+		Text.Appendf(TEXT("# %s\n"), *Context);
+		Text.Append(TEXT("Type,Name,Count,ObjectBytes,ResourceBytes\n"));
+
+		auto AppendEntries = [&Text](const TCHAR* Type, const TMap<FName, FSnapshotEntry>& Entries)
+		{
+			for (const TPair<FName, FSnapshotEntry>& Pair : Entries)
+			{
+				Text.Appendf(TEXT("%s,%s,%lld,%lld,%lld\n"), Type, *Pair.Key.ToString(), Pair.Value.Count, Pair.Value.ObjectBytes, Pair.Value.ResourceBytes);
+			}
+		};
+		AppendEntries(TEXT("Class"), Snapshot.Classes);
+		AppendEntries(TEXT("Package"), Snapshot.Packages);
+
+		if (FFileHelper::SaveStringToFile(Text.ToView(), *Filename))
+		{
+			UE_LOG(LogNL, Log, TEXT("Wrote memory snapshot with %d classes and %d packages to %s"), Snapshot.Classes.Num(), Snapshot.Packages.Num(), *Filename);
+		}
+		else
+		{
+			UE_LOG(LogNL, Warning, TEXT("Failed to write memory snapshot %s"), *Filename);
+		}
+	}
+
+	static bool ReadSnapshot(const FString& Filename, FSnapshot& OutSnapshot)
+	{
+		TArray<FString> Lines;
+		if (!FFileHelper::LoadFileToStringArray(Lines, *Filename))
+		{
+			return false;
+		}
+
+		for (const FString& Line : Lines)
+		{
+			TArray<FString> Columns;
+			if (Line.StartsWith(TEXT("#")) || (Line.ParseIntoArray(Columns, TEXT(","), /*InCullEmpty=*/ false) != 5) || !Columns[2].IsNumeric())
+			{
+				continue;
+			}
+
+			TMap<FName, FSnapshotEntry>& Entries = (Columns[0] == TEXT("Class")) ? OutSnapshot.Classes : OutSnapshot.Packages;
+			FSnapshotEntry& Entry = Entries.Add(FName(*Columns[1]));
+			LexFromString(Entry.Count, *Columns[2]);
+			LexFromString(Entry.ObjectBytes, *Columns[3]);
+			LexFromString(Entry.ResourceBytes, *Columns[4]);
+		}
+
+		return true;
+	}
+
+	// Accepts a full path, or a snapshot name relative to the snapshot dir (with or without extension)
+	static FString ResolveSnapshotFilename(const FString& Name)
+	{
+		if (FPaths::FileExists(Name))
+		{
+			return Name;
+		}
+
+		const FString RelativeName = GetSnapshotDir() / Name;
+		return FPaths::FileExists(RelativeName) ? RelativeName : (RelativeName + TEXT(".csv"));
+	}
+
+	static void TakeSample(const FString& Label)
+	{
+		check(IsInGameThread());
+
+		if (bSampleInFlight.exchange(true))
+		{
+			UE_LOG(LogNL, Log, TEXT("Skipping memory sample, the previous one is still being written"));
+			return;
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		TArray<FObjectRecord> Records;
+		Records.Reserve(GUObjectArray.GetObjectArrayNumMinusAvailable());
+
+		for (TObjectIterator<UObject> It; It; ++It)
+		{
+			UObject* Obj = *It;
+			const UClass* Class = Obj->GetClass();
+
+			FObjectRecord& Record = Records.AddDefaulted_GetRef();
+			Record.ClassName = Class->GetFName();
+			Record.PackageName = Obj->GetOutermost()->GetFName();
+			Record.ObjectBytes = Class->GetStructureSize();
+
+			if (bIncludeResourceSize)
+			{
+				FResourceSizeEx ResourceSize(EResourceSizeMode::Exclusive);
+				Obj->GetResourceSizeEx(ResourceSize);
+				Record.ResourceBytes = ResourceSize.GetTotalMemoryBytes();
+			}
+		}
+
+		const FString Suffix = Label.IsEmpty() ? FString() : (TEXT("_") + Label);
+		const FString Filename = GetSnapshotDir() / FString::Printf(TEXT("MemSnapshot_%s%s.csv"), *FDateTime::Now().ToString(), *Suffix);
+		const FString Context = FString::Printf(TEXT("%s, map %s, %d objects"), *FDateTime::Now().ToString(), (GWorld != nullptr) ? *GWorld->GetMapName() : TEXT("none"), Records.Num());
+
+		UE_LOG(LogNL, Verbose, TEXT("Recorded %d objects for a memory sample in %.1f ms"), Records.Num(), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+		UE::Tasks::Launch(UE_SOURCE_LOCATION, [Records = MoveTemp(Records), Filename, Context]()
+		{
+			FSnapshot Snapshot;
+			for (const FObjectRecord& Record : Records)
+			{
+				for (FSnapshotEntry* Entry : { &Snapshot.Classes.FindOrAdd(Record.ClassName), &Snapshot.Packages.FindOrAdd(Record.PackageName) })
+				{
+					++Entry->Count;
+					Entry->ObjectBytes += Record.ObjectBytes;
+					Entry->ResourceBytes += Record.ResourceBytes;
+				}
+			}
+
+			WriteSnapshot(Filename, Context, Snapshot);
+			bSampleInFlight.store(false);
+		});
+	}
+
+	static void UpdateSampleTicker()
+	{
+		if (SampleTickerHandle.IsValid())
+		{
+			FTSTicker::GetCoreTicker().RemoveTicker(SampleTickerHandle);
+			SampleTickerHandle.Reset();
+		}
+
+		if (SampleInterval > 0.0f)
+		{
+			SampleTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([](float DeltaTime)
+			{
+				TakeSample(TEXT("Periodic"));
+				return true;
+			}), SampleInterval);
+		}
+	}
+
+	static FAutoConsoleVariableRef CVarSampleInterval(
+		TEXT("NL.MemSample.Interval"),
+		SampleInterval,
+		TEXT("When above zero, a memory snapshot (see NL.MemSample) is taken every this many seconds."),
+		FConsoleVariableDelegate::CreateLambda([](IConsoleVariable*) { UpdateSampleTicker(); }),
+		ECVF_Default);
+
+	static FAutoConsoleVariableRef CVarIncludeResourceSize(
+		TEXT("NL.MemSample.IncludeResourceSize"),
+		bIncludeResourceSize,
+		TEXT("Whether memory snapshots include each object's exclusive resource size (GetResourceSizeEx), which makes sampling slower."),
+		ECVF_Default);
+
+	static void LogDiff(const TCHAR* Title, const TMap<FName, FSnapshotEntry>& Before, const TMap<FName, FSnapshotEntry>& After, int32 MaxRows)
+	{
+		struct FDiffRow
+		{
+			FName Name;
+			int64 CountDelta = 0;
+			int64 BytesDelta = 0;
+			int64 BytesAfter = 0;
+		};
+
+		TArray<FDiffRow> Rows;
+		TSet<FName> Names;
+		Before.GetKeys(Names);
+		for (const TPair<FName, FSnapshotEntry>& Pair : After)
+		{
+			Names.Add(Pair.Key);
+		}
+
+		for (const FName& Name : Names)
+		{
+			const FSnapshotEntry* BeforeEntry = Before.Find(Name);
+			const FSnapshotEntry* AfterEntry = After.Find(Name);
+
+			FDiffRow Row;
+			Row.Name = Name;
+			Row.CountDelta = (AfterEntry ? AfterEntry->Count : 0) - (BeforeEntry ? BeforeEntry->Count : 0);
+			Row.BytesAfter = AfterEntry ? AfterEntry->GetTotalBytes() : 0;
+			Row.BytesDelta = Row.BytesAfter - (BeforeEntry ? BeforeEntry->GetTotalBytes() : 0);
+
+			if ((Row.CountDelta != 0) || (Row.BytesDelta != 0))
+			{
+				Rows.Add(Row);
+			}
+		}
+
+		// Biggest growth first, ties broken by instance count growth (leaked objects without resources)
+		Rows.Sort([](const FDiffRow& A, const FDiffRow& B)
+		{
+			return (A.BytesDelta != B.BytesDelta) ? (A.BytesDelta > B.BytesDelta) : (A.CountDelta > B.CountDelta);
+		});
+
+		UE_LOG(LogNL, Log, TEXT("  %s (%d changed)"), Title, Rows.Num());
+		UE_LOG(LogNL, Log, TEXT("  %12s %14s %14s  %s"), TEXT("CountDelta"), TEXT("KBDelta"), TEXT("KBAfter"), TEXT("Name"));
+		for (int32 Index = 0; Index < FMath::Min(Rows.Num(), MaxRows); ++Index)
+		{
+			const FDiffRow& Row = Rows[Index];
+			UE_LOG(LogNL, Log, TEXT("  %+12lld %+14.1f %14.1f  %s"), Row.CountDelta, Row.BytesDelta / 1024.0, Row.BytesAfter / 1024.0, *Row.Name.ToString());
+		}
+	}
+}
+
+FAutoConsoleCommandWithWorldAndArgs GMemSampleCmd(
+	TEXT("NL.MemSample"),
+	TEXT("Writes a snapshot of per class and per package object counts and sizes to the profiling dir. Usage: NL.MemSample [Label]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(
+		[](const TArray<FString>& Params, UWorld* World)
+{
+	NLMemorySampler::TakeSample((Params.Num() > 0) ? Params[0] : FString());
+}));
+
+FAutoConsoleCommandWithWorldAndArgs GMemDiffCmd(
+	TEXT("NL.MemDiff"),
+	TEXT("Reports the growth by class and by outer package between two memory snapshots. Usage: NL.MemDiff SnapshotA SnapshotB [MaxRows=30]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(
+		[](const TArray<FString>& Params, UWorld* World)
+{
+	using namespace NLMemorySampler;
+
+	if (Params.Num() < 2)
+	{
+		TArray<FString> SnapshotNames;
+		IFileManager::Get().FindFiles(SnapshotNames, *(GetSnapshotDir() / TEXT("*.csv")), /*Files=*/ true, /*Directories=*/ false);
+		SnapshotNames.Sort();
+
+		UE_LOG(LogNL, Log, TEXT("Usage: NL.MemDiff SnapshotA SnapshotB [MaxRows]. Snapshots in %s:"), *GetSnapshotDir());
+		for (const FString& SnapshotName : SnapshotNames)
+		{
+			UE_LOG(LogNL, Log, TEXT("  %s"), *SnapshotName);
+		}
+		return;
+	}
+
+	const FString FilenameA = ResolveSnapshotFilename(Params[0]);
+	const FString FilenameB = ResolveSnapshotFilename(Params[1]);
+	const int32 MaxRows = (Params.Num() > 2) ? FCString::Atoi(*Params[2]) : 30;
+
+	FSnapshot SnapshotA;
+	FSnapshot SnapshotB;
+	if (!ReadSnapshot(FilenameA, SnapshotA) || !ReadSnapshot(FilenameB, SnapshotB))
+	{
+		UE_LOG(LogNL, Warning, TEXT("NL.MemDiff: could not read %s or %s"), *FilenameA, *FilenameB);
+		return;
+	}
+
+	UE_LOG(LogNL, Log, TEXT("========== Memory growth from %s to %s =========="), *FPaths::GetCleanFilename(FilenameA), *FPaths::GetCleanFilename(FilenameB));
+	LogDiff(TEXT("By class"), SnapshotA.Classes, SnapshotB.Classes, MaxRows);
+	LogDiff(TEXT("By package"), SnapshotA.Packages, SnapshotB.Packages, MaxRows);
+	UE_LOG(LogNL, Log, TEXT("========== End of memory growth =========="));
+}));
+
+#endif // ALLOW_DEBUG_FILES
+
+//////////////////////////////////////////////////////////////////////////
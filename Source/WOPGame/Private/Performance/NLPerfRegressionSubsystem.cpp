@@ -0,0 +1,670 @@
+// Copyright 2025 Noblon GmbH. All Rights Reserved.
+
+#include "Performance/NLPerfRegressionSubsystem.h"
+
+#include "AI/NLBotCreationActor.h"
+#include "AIController.h"
+#include "Abilities/NLAbilitySystemComponent.h"
+#include "Dom/JsonObject.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerStart.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "NavigationSystem.h"
+#include "NLLogChannels.h"
+#include "Pawns/NLPawnData.h"
+#include "Pawns/NLPawnExtensionComponent.h"
+#include "Performance/NLHitchCapture.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "System/NLAssetManager.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(NLPerfRegressionSubsystem)
+
+//////////////////////////////////////////////////////////////////////
+
+namespace NLPerfRegression
+{
+	enum EExitCode : int32
+	{
+		Passed = 0,
+		Regressed = 1,
+		Error = 2,
+	};
+
+	struct FMetricSummary
+	{
+		double Mean = 0.0;
+		double P50 = 0.0;
+		double P95 = 0.0;
+		double P99 = 0.0;
+		double Max = 0.0;
+	};
+
+	static FMetricSummary Summarize(const TArray<float>& Samples)
+	{
+		FMetricSummary Summary;
+		if (Samples.Num() == 0)
+		{
+			return Summary;
+		}
+
+		TArray<float> Sorted = Samples;
+		Sorted.Sort();
+
+		auto GetPercentile = [&Sorted](double Fraction)
+		{
+			return Sorted[FMath::Clamp(FMath::CeilToInt32(Fraction * Sorted.Num()) - 1, 0, Sorted.Num() - 1)];
+		};
+
+		double Sum = 0.0;
+		for (float Sample : Sorted)
+		{
+			Sum += Sample;
+		}
+
+		Summary.Mean = Sum / Sorted.Num();
+		Summary.P50 = GetPercentile(0.50);
+		Summary.P95 = GetPercentile(0.95);
+		Summary.P99 = GetPercentile(0.99);
+		Summary.Max = Sorted.Last();
+		return Summary;
+	}
+
+	// The stats that are compared against the baseline, max is reported but too noisy to gate on
+	static const TCHAR* ComparedStats[] = { TEXT("mean"), TEXT("p50"), TEXT("p95"), TEXT("p99") };
+
+	// The object in the results that holds the WOPGame scopes, next to "metrics"
+	static const TCHAR* ScopesFieldName = TEXT("wopGameStats");
+}
+
+//////////////////////////////////////////////////////////////////////
+// UNLPerfRegressionSubsystem
+
+bool UNLPerfRegressionSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+#if UE_BUILD_SHIPPING
+	return false;
+#else
+	const UWorld* World = Cast<UWorld>(Outer);
+	FString Name;
+	return Super::ShouldCreateSubsystem(Outer) && (World != nullptr) && World->IsGameWorld() && FParse::Value(FCommandLine::Get(), TEXT("NLPerfTest="), Name);
+#endif
+}
+
+void UNLPerfRegressionSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FParse::Value(FCommandLine::Get(), TEXT("NLPerfTest="), BaselineName);
+	bUpdateBaseline = FParse::Param(FCommandLine::Get(), TEXT("NLPerfTestUpdateBaseline"));
+
+	WorldTickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &ThisClass::HandleWorldTickStart);
+	WorldPostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &ThisClass::HandleWorldPostActorTick);
+}
+
+void UNLPerfRegressionSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandle);
+	FWorldDelegates::OnWorldPostActorTick.Remove(WorldPostActorTickHandle);
+
+	if ((State == ERunState::Warmup) || (State == ERunState::Measure))
+	{
+		FinishRun(NLPerfRegression::Error, TEXT("The world was torn down before the run completed"));
+	}
+
+	Super::Deinitialize();
+}
+
+void UNLPerfRegressionSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Bots need a server, clients connected to a perf test server just play along
+	if (InWorld.GetAuthGameMode() == nullptr)
+	{
+		UE_LOG(LogNL, Log, TEXT("Perf test %s: not the authority, nothing to do"), *BaselineName);
+		return;
+	}
+
+	// Started on the first tick so the game mode has started play before bots join
+	State = ERunState::Warmup;
+	StateStartTime = -1.0;
+}
+
+TStatId UNLPerfRegressionSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNLPerfRegressionSubsystem, STATGROUP_Tickables);
+}
+
+void UNLPerfRegressionSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if ((State == ERunState::Idle) || (State == ERunState::Finished))
+	{
+		return;
+	}
+
+	if (StateStartTime < 0.0)
+	{
+		StartRun();
+		return;
+	}
+
+	DriveBots(DeltaTime);
+
+	const double Now = FPlatformTime::Seconds();
+	if (State == ERunState::Warmup)
+	{
+		if (Now - StateStartTime >= Settings.WarmupSeconds)
+		{
+			UE_LOG(LogNL, Display, TEXT("Perf test %s: warmup done, measuring for %.0f seconds"), *BaselineName, Settings.DurationSeconds);
+			State = ERunState::Measure;
+			StateStartTime = Now;
+			LastScopeSampleCycles = FPlatformTime::Cycles64();
+		}
+	}
+	else if (State == ERunState::Measure)
+	{
+		FrameTimeMetric.Samples.Add(FApp::GetDeltaTime() * 1000.0);
+		GameThreadTimeMetric.Samples.Add(FPlatformTime::ToMilliseconds(GGameThreadTime));
+		ServerTickTimeMetric.Samples.Add(LastServerTickMS);
+		SampleScopeTimes();
+
+		if (Now - StateStartTime >= Settings.DurationSeconds)
+		{
+			FString Report;
+			const bool bPassed = bUpdateBaseline || CompareToBaseline(Report);
+			FinishRun(bPassed ? NLPerfRegression::Passed : NLPerfRegression::Regressed, Report);
+		}
+	}
+}
+
+void UNLPerfRegressionSubsystem::StartRun()
+{
+	if (!LoadSettings())
+	{
+		return;
+	}
+
+	if (FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld()) == nullptr)
+	{
+		FinishRun(NLPerfRegression::Error, TEXT("The map has no navigation system, bots can't be spawned"));
+		return;
+	}
+
+	if (!SpawnBots())
+	{
+		return;
+	}
+
+#if NL_HITCH_CAPTURE_ENABLED
+	// The WOPGame scope times come from the hitch capture ring buffers, which are only filled while it is enabled
+	if (!NLHitchCapture::bEnabled)
+	{
+		if (IConsoleVariable* CVarHitchCapture = IConsoleManager::Get().FindConsoleVariable(TEXT("NL.HitchCapture")))
+		{
+			UE_LOG(LogNL, Display, TEXT("Perf test %s: enabling NL.HitchCapture to record WOPGame scope times"), *BaselineName);
+			CVarHitchCapture->Set(true, ECVF_SetByCode);
+		}
+	}
+#endif
+
+	RandomStream.Initialize(Settings.Seed);
+	TimeUntilNextMove = 0.0f;
+	TimeUntilNextInput = Settings.InputIntervalSeconds;
+
+#if CSV_PROFILER
+	if (FCsvProfiler* CsvProfiler = FCsvProfiler::Get())
+	{
+		CsvProfiler->BeginCapture(-1, FPaths::ProjectSavedDir() / TEXT("PerfRegression"), FString::Printf(TEXT("%s_%s.csv"), *BaselineName, *FDateTime::Now().ToString()));
+	}
+#endif
+
+	UE_LOG(LogNL, Display, TEXT("Perf test %s: %d bots, %.0f seconds warmup"), *BaselineName, BotCreationActor->GetSpawnedBots().Num(), Settings.WarmupSeconds);
+
+	State = ERunState::Warmup;
+	StateStartTime = FPlatformTime::Seconds();
+}
+
+void UNLPerfRegressionSubsystem::FinishRun(int32 ExitCode, const FString& Report)
+{
+	State = ERunState::Finished;
+
+#if CSV_PROFILER
+	if (FCsvProfiler* CsvProfiler = FCsvProfiler::Get())
+	{
+		if (CsvProfiler->IsCapturing())
+		{
+			CsvProfiler->EndCapture();
+		}
+	}
+#endif
+
+	const FString OutputBase = FPaths::ProjectSavedDir() / TEXT("PerfRegression") / FString::Printf(TEXT("%s_%s"), *BaselineName, *FDateTime::Now().ToString());
+
+	if (FrameTimeMetric.Samples.Num() > 0)
+	{
+		FString ResultsString;
+		FJsonSerializer::Serialize(MakeResultsJson(), TJsonWriterFactory<>::Create(&ResultsString));
+
+		const FString ResultsFilename = bUpdateBaseline ? GetBaselineFilename() : (OutputBase + TEXT(".json"));
+		if (FFileHelper::SaveStringToFile(ResultsString, *ResultsFilename))
+		{
+			UE_LOG(LogNL, Display, TEXT("Perf test %s: results written to %s"), *BaselineName, *ResultsFilename);
+		}
+		else
+		{
+			UE_LOG(LogNL, Error, TEXT("Perf test %s: failed to write %s"), *BaselineName, *ResultsFilename);
+			ExitCode = NLPerfRegression::Error;
+		}
+	}
+
+	const TCHAR* ResultText = (ExitCode == NLPerfRegression::Passed) ? TEXT("PASSED") : ((ExitCode == NLPerfRegression::Regressed) ? TEXT("REGRESSED") : TEXT("ERROR"));
+	const FString FullReport = FString::Printf(TEXT("Perf test %s on %s: %s\n%s\n"), *BaselineName, *GetWorld()->GetOutermost()->GetName(), ResultText, *Report);
+
+	FFileHelper::SaveStringToFile(FullReport, *(OutputBase + TEXT("_Report.txt")));
+	if (ExitCode == NLPerfRegression::Passed)
+	{
+		UE_LOG(LogNL, Display, TEXT("%s"), *FullReport);
+	}
+	else
+	{
+		UE_LOG(LogNL, Error, TEXT("%s"), *FullReport);
+	}
+
+	// Leave the editor running when testing the harness in PIE
+	if (!GIsEditor)
+	{
+		FPlatformMisc::RequestExitWithStatus(/*Force=*/ false, (uint8)ExitCode);
+	}
+}
+
+FString UNLPerfRegressionSubsystem::GetBaselineFilename() const
+{
+	return FPaths::ProjectConfigDir() / TEXT("PerfBaselines") / (BaselineName + TEXT(".json"));
+}
+
+bool UNLPerfRegressionSubsystem::LoadSettings()
+{
+	FString BaselineString;
+	if (FFileHelper::LoadFileToString(BaselineString, *GetBaselineFilename()))
+	{
+		if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineString), Baseline) || !Baseline.IsValid())
+		{
+			FinishRun(NLPerfRegression::Error, FString::Printf(TEXT("%s is not valid JSON"), *GetBaselineFilename()));
+			return false;
+		}
+
+		FString BaselineMap;
+		if (Baseline->TryGetStringField(TEXT("map"), BaselineMap) && (BaselineMap != GetWorld()->GetOutermost()->GetName()) && !bUpdateBaseline)
+		{
+			FinishRun(NLPerfRegression::Error, FString::Printf(TEXT("The baseline was recorded on %s"), *BaselineMap));
+			return false;
+		}
+
+		// A baseline that only holds the run settings has not been recorded yet, which is a setup problem and not a regression
+		if (!Baseline->HasTypedField<EJson::Object>(TEXT("metrics")) && !bUpdateBaseline)
+		{
+			FinishRun(NLPerfRegression::Error, FString::Printf(TEXT("%s has no recorded metrics, record them on the reference machine with -NLPerfTestUpdateBaseline"), *GetBaselineFilename()));
+			return false;
+		}
+
+		const TSharedPtr<FJsonObject>* SettingsObject = nullptr;
+		if (Baseline->TryGetObjectField(TEXT("settings"), SettingsObject))
+		{
+			const FJsonObject& Json = **SettingsObject;
+			Json.TryGetNumberField(TEXT("bots"), Settings.NumBots);
+			Json.TryGetNumberField(TEXT("warmupSeconds"), Settings.WarmupSeconds);
+			Json.TryGetNumberField(TEXT("durationSeconds"), Settings.DurationSeconds);
+			Json.TryGetNumberField(TEXT("tolerancePercent"), Settings.TolerancePercent);
+			Json.TryGetNumberField(TEXT("absoluteToleranceMs"), Settings.AbsoluteToleranceMS);
+			Json.TryGetNumberField(TEXT("botSpawnRadius"), Settings.BotSpawnRadius);
+			Json.TryGetNumberField(TEXT("moveIntervalSeconds"), Settings.MoveIntervalSeconds);
+			Json.TryGetNumberField(TEXT("inputIntervalSeconds"), Settings.InputIntervalSeconds);
+			Json.TryGetNumberField(TEXT("seed"), Settings.Seed);
+
+			FString PathString;
+			if (Json.TryGetStringField(TEXT("botPawnData"), PathString))
+			{
+				Settings.BotPawnData = FSoftObjectPath(PathString);
+			}
+			if (Json.TryGetStringField(TEXT("botController"), PathString))
+			{
+				Settings.BotControllerClass = FSoftClassPath(PathString);
+			}
+
+			TArray<FString> InputTagNames;
+			if (Json.TryGetStringArrayField(TEXT("inputTags"), InputTagNames))
+			{
+				for (const FString& InputTagName : InputTagNames)
+				{
+					const FGameplayTag InputTag = FGameplayTag::RequestGameplayTag(FName(*InputTagName), /*ErrorIfNotFound=*/ false);
+					if (InputTag.IsValid())
+					{
+						Settings.InputTags.Add(InputTag);
+					}
+					else
+					{
+						UE_LOG(LogNL, Warning, TEXT("Perf test %s: unknown input tag %s"), *BaselineName, *InputTagName);
+					}
+				}
+			}
+		}
+	}
+	else if (!bUpdateBaseline)
+	{
+		FinishRun(NLPerfRegression::Error, FString::Printf(TEXT("No baseline at %s, run with -NLPerfTestUpdateBaseline to record one"), *GetBaselineFilename()));
+		return false;
+	}
+
+	FParse::Value(FCommandLine::Get(), TEXT("NLPerfTestBots="), Settings.NumBots);
+	FParse::Value(FCommandLine::Get(), TEXT("NLPerfTestWarmup="), Settings.WarmupSeconds);
+	FParse::Value(FCommandLine::Get(), TEXT("NLPerfTestDuration="), Settings.DurationSeconds);
+
+	return true;
+}
+
+bool UNLPerfRegressionSubsystem::SpawnBots()
+{
+	UWorld* World = GetWorld();
+
+	FNLBotCreationEntry Entry;
+	Entry.BotName = TEXT("PerfTestBot");
+	Entry.NumBotsToCreate = Settings.NumBots;
+	Entry.BotPawnData = Settings.BotPawnData.IsValid() ? Cast<UNLPawnData>(Settings.BotPawnData.TryLoad()) : UNLAssetManager::Get().GetDefaultPawnData();
+	Entry.BotControllerClass = Settings.BotControllerClass.IsValid() ? Settings.BotControllerClass.TryLoadClass<AAIController>() : AAIController::StaticClass();
+
+	if ((Entry.BotPawnData == nullptr) || (Entry.BotControllerClass == nullptr))
+	{
+		FinishRun(NLPerfRegression::Error, TEXT("Could not resolve the bot pawn data or controller class"));
+		return false;
+	}
+
+	FTransform SpawnTransform = FTransform::Identity;
+	for (TActorIterator<APlayerStart> It(World); It; ++It)
+	{
+		SpawnTransform = It->GetActorTransform();
+		break;
+	}
+
+	BotCreationActor = World->SpawnActorDeferred<ANLBotCreationActor>(ANLBotCreationActor::StaticClass(), SpawnTransform);
+	BotCreationActor->SetBotCreationEntries({ Entry }, Settings.BotSpawnRadius);
+	BotCreationActor->FinishSpawning(SpawnTransform);
+
+	return true;
+}
+
+void UNLPerfRegressionSubsystem::DriveBots(float DeltaTime)
+{
+	if (BotCreationActor == nullptr)
+	{
+		return;
+	}
+
+	const TArray<TObjectPtr<AAIController>>& Bots = BotCreationActor->GetSpawnedBots();
+
+	auto ForEachBotAbilitySystem = [&Bots](TFunctionRef<void(UNLAbilitySystemComponent&)> Func)
+	{
+		for (AAIController* Bot : Bots)
+		{
+			const UNLPawnExtensionComponent* PawnExtComp = (Bot != nullptr) ? UNLPawnExtensionComponent::FindPawnExtensionComponent(Bot->GetPawn()) : nullptr;
+			if (UNLAbilitySystemComponent* AbilitySystem = (PawnExtComp != nullptr) ? PawnExtComp->GetNLAbilitySystemComponent() : nullptr)
+			{
+				Func(*AbilitySystem);
+			}
+		}
+	};
+
+	// Keep everyone walking around, destinations come from the seeded stream so runs are comparable
+	TimeUntilNextMove -= DeltaTime;
+	if (TimeUntilNextMove <= 0.0f)
+	{
+		TimeUntilNextMove = Settings.MoveIntervalSeconds;
+
+		const UNavigationSystemV1* NavSys = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+		for (AAIController* Bot : Bots)
+		{
+			const APawn* Pawn = (Bot != nullptr) ? Bot->GetPawn() : nullptr;
+			if (Pawn == nullptr)
+			{
+				continue;
+			}
+
+			const FVector2D Offset = FVector2D(RandomStream.FRandRange(-1.0f, 1.0f), RandomStream.FRandRange(-1.0f, 1.0f)) * Settings.BotSpawnRadius;
+			const FVector Destination = BotCreationActor->GetActorLocation() + FVector(Offset, 0.0f);
+
+			FNavLocation NavLocation;
+			if (NavSys->ProjectPointToNavigation(Destination, NavLocation, FVector(Settings.BotSpawnRadius, Settings.BotSpawnRadius, 1000.0f)))
+			{
+				Bot->MoveToLocation(NavLocation.Location);
+			}
+		}
+	}
+
+	if (Settings.InputTags.Num() == 0)
+	{
+		return;
+	}
+
+	// AI controllers don't process ability input on their own, presses are released again on the next tick
+	if (bInputHeld)
+	{
+		const FGameplayTag HeldInputTag = Settings.InputTags[(NextInputTagIndex - 1) % Settings.InputTags.Num()];
+		ForEachBotAbilitySystem([HeldInputTag, DeltaTime](UNLAbilitySystemComponent& AbilitySystem)
+		{
+			AbilitySystem.AbilityInputTagReleased(HeldInputTag);
+			AbilitySystem.ProcessAbilityInput(DeltaTime, /*bGamePaused=*/ false);
+		});
+		bInputHeld = false;
+	}
+
+	TimeUntilNextInput -= DeltaTime;
+	if (TimeUntilNextInput <= 0.0f)
+	{
+		TimeUntilNextInput = Settings.InputIntervalSeconds;
+
+		const FGameplayTag InputTag = Settings.InputTags[NextInputTagIndex++ % Settings.InputTags.Num()];
+		ForEachBotAbilitySystem([InputTag, DeltaTime](UNLAbilitySystemComponent& AbilitySystem)
+		{
+			AbilitySystem.AbilityInputTagPressed(InputTag);
+			AbilitySystem.ProcessAbilityInput(DeltaTime, /*bGamePaused=*/ false);
+		});
+		bInputHeld = true;
+	}
+}
+
+void UNLPerfRegressionSubsystem::HandleWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld == GetWorld())
+	{
+		WorldTickStartTime = FPlatformTime::Seconds();
+	}
+}
+
+void UNLPerfRegressionSubsystem::HandleWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (InWorld == GetWorld())
+	{
+		LastServerTickMS = (float)((FPlatformTime::Seconds() - WorldTickStartTime) * 1000.0);
+	}
+}
+
+void UNLPerfRegressionSubsystem::SampleScopeTimes()
+{
+#if NL_HITCH_CAPTURE_ENABLED
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+	FrameScopeMS.Reset();
+	NLHitchCapture::SumScopeTimes(LastScopeSampleCycles, NowCycles, FrameScopeMS);
+	LastScopeSampleCycles = NowCycles;
+
+	// One sample per measured frame for every scope, frames where a scope didn't run count as zero
+	const int32 NumFrames = FrameTimeMetric.Samples.Num();
+	for (TPair<FName, FMetric>& Pair : ScopeMetrics)
+	{
+		Pair.Value.Samples.Add(0.0f);
+	}
+
+	for (const TPair<const TCHAR*, double>& Pair : FrameScopeMS)
+	{
+		FMetric& Metric = ScopeMetrics.FindOrAdd(FName(Pair.Key));
+		if (Metric.Name == nullptr)
+		{
+			// Scope names are string literals, so the pointer stays valid for the rest of the run
+			Metric.Name = Pair.Key;
+			Metric.bGated = true;
+			Metric.Samples.AddZeroed(NumFrames);
+		}
+		Metric.Samples.Last() += (float)Pair.Value;
+	}
+#endif
+}
+
+TArray<const UNLPerfRegressionSubsystem::FMetric*> UNLPerfRegressionSubsystem::GetScopeMetrics() const
+{
+	TArray<const FMetric*> Metrics;
+	Metrics.Reserve(ScopeMetrics.Num());
+	for (const TPair<FName, FMetric>& Pair : ScopeMetrics)
+	{
+		Metrics.Add(&Pair.Value);
+	}
+	Metrics.Sort([](const FMetric& A, const FMetric& B) { return FCString::Strcmp(A.Name, B.Name) < 0; });
+	return Metrics;
+}
+
+TSharedRef<FJsonObject> UNLPerfRegressionSubsystem::MakeMetricsJson(TConstArrayView<const FMetric*> Metrics)
+{
+	TSharedRef<FJsonObject> MetricsJson = MakeShared<FJsonObject>();
+	for (const FMetric* Metric : Metrics)
+	{
+		const NLPerfRegression::FMetricSummary Summary = NLPerfRegression::Summarize(Metric->Samples);
+
+		TSharedRef<FJsonObject> MetricJson = MakeShared<FJsonObject>();
+		MetricJson->SetNumberField(TEXT("mean"), Summary.Mean);
+		MetricJson->SetNumberField(TEXT("p50"), Summary.P50);
+		MetricJson->SetNumberField(TEXT("p95"), Summary.P95);
+		MetricJson->SetNumberField(TEXT("p99"), Summary.P99);
+		MetricJson->SetNumberField(TEXT("max"), Summary.Max);
+		MetricJson->SetNumberField(TEXT("samples"), Metric->Samples.Num());
+		MetricsJson->SetObjectField(Metric->Name, MetricJson);
+	}
+	return MetricsJson;
+}
+
+TSharedRef<FJsonObject> UNLPerfRegressionSubsystem::MakeResultsJson() const
+{
+	TSharedRef<FJsonObject> SettingsJson = MakeShared<FJsonObject>();
+	SettingsJson->SetNumberField(TEXT("bots"), Settings.NumBots);
+	SettingsJson->SetNumberField(TEXT("warmupSeconds"), Settings.WarmupSeconds);
+	SettingsJson->SetNumberField(TEXT("durationSeconds"), Settings.DurationSeconds);
+	SettingsJson->SetNumberField(TEXT("tolerancePercent"), Settings.TolerancePercent);
+	SettingsJson->SetNumberField(TEXT("absoluteToleranceMs"), Settings.AbsoluteToleranceMS);
+	SettingsJson->SetNumberField(TEXT("botSpawnRadius"), Settings.BotSpawnRadius);
+	SettingsJson->SetNumberField(TEXT("moveIntervalSeconds"), Settings.MoveIntervalSeconds);
+	SettingsJson->SetNumberField(TEXT("inputIntervalSeconds"), Settings.InputIntervalSeconds);
+	SettingsJson->SetNumberField(TEXT("seed"), Settings.Seed);
+	SettingsJson->SetStringField(TEXT("botPawnData"), Settings.BotPawnData.ToString());
+	SettingsJson->SetStringField(TEXT("botController"), Settings.BotControllerClass.ToString());
+
+	TArray<TSharedPtr<FJsonValue>> InputTagValues;
+	for (const FGameplayTag& InputTag : Settings.InputTags)
+	{
+		InputTagValues.Add(MakeShared<FJsonValueString>(InputTag.ToString()));
+	}
+	SettingsJson->SetArrayField(TEXT("inputTags"), InputTagValues);
+
+	TSharedRef<FJsonObject> Results = MakeShared<FJsonObject>();
+	Results->SetStringField(TEXT("map"), GetWorld()->GetOutermost()->GetName());
+	Results->SetStringField(TEXT("recorded"), FDateTime::UtcNow().ToIso8601());
+	Results->SetObjectField(TEXT("settings"), SettingsJson);
+	Results->SetObjectField(TEXT("metrics"), MakeMetricsJson({ &FrameTimeMetric, &GameThreadTimeMetric, &ServerTickTimeMetric }));
+	Results->SetObjectField(NLPerfRegression::ScopesFieldName, MakeMetricsJson(GetScopeMetrics()));
+	return Results;
+}
+
+bool UNLPerfRegressionSubsystem::CompareMetrics(const TCHAR* FieldName, TConstArrayView<const FMetric*> Metrics, const FJsonObject& Results, bool bRequireBaseline, FString& OutReport) const
+{
+	const TSharedPtr<FJsonObject>* BaselineMetrics = nullptr;
+	if (!Baseline->TryGetObjectField(FieldName, BaselineMetrics))
+	{
+		OutReport += FString::Printf(TEXT("%s has no %s\n"), *GetBaselineFilename(), FieldName);
+		return !bRequireBaseline;
+	}
+
+	const TSharedPtr<FJsonObject> CurrentMetrics = Results.GetObjectField(FieldName);
+
+	int32 NameWidth = 14;
+	for (const FMetric* Metric : Metrics)
+	{
+		NameWidth = FMath::Max(NameWidth, FCString::Strlen(Metric->Name));
+	}
+
+	bool bPassed = true;
+	OutReport += FString::Printf(TEXT("%s %-5s %10s %10s %9s %10s  %s\n"), *FString(TEXT("Metric")).RightPad(NameWidth), TEXT("Stat"), TEXT("Baseline"), TEXT("Current"), TEXT("Delta"), TEXT("Limit"), TEXT("Result"));
+
+	for (const FMetric* Metric : Metrics)
+	{
+		const FString PaddedName = FString(Metric->Name).RightPad(NameWidth);
+
+		const TSharedPtr<FJsonObject>* BaselineMetric = nullptr;
+		if (!(*BaselineMetrics)->TryGetObjectField(Metric->Name, BaselineMetric))
+		{
+			OutReport += FString::Printf(TEXT("%s missing from the baseline\n"), *PaddedName);
+			bPassed &= !(Metric->bGated && bRequireBaseline);
+			continue;
+		}
+
+		const TSharedPtr<FJsonObject> CurrentMetric = CurrentMetrics->GetObjectField(Metric->Name);
+		for (const TCHAR* Stat : NLPerfRegression::ComparedStats)
+		{
+			double BaselineValue = 0.0;
+			(*BaselineMetric)->TryGetNumberField(Stat, BaselineValue);
+			const double CurrentValue = CurrentMetric->GetNumberField(Stat);
+			const double Limit = BaselineValue * (1.0 + Settings.TolerancePercent / 100.0) + Settings.AbsoluteToleranceMS;
+			const double DeltaPercent = (BaselineValue > 0.0) ? (100.0 * (CurrentValue - BaselineValue) / BaselineValue) : 0.0;
+
+			const bool bRegressed = (CurrentValue > Limit);
+			const TCHAR* Result = !bRegressed ? TEXT("ok") : (Metric->bGated ? TEXT("REGRESSED") : TEXT("slower (not gated)"));
+			bPassed &= !(bRegressed && Metric->bGated);
+
+			OutReport += FString::Printf(TEXT("%s %-5s %10.3f %10.3f %+8.1f%% %10.3f  %s\n"), *PaddedName, Stat, BaselineValue, CurrentValue, DeltaPercent, Limit, Result);
+		}
+	}
+
+	// Scopes that no longer run can't regress, but removing one should be visible in the report
+	for (const TPair<FString, TSharedPtr<FJsonValue>>& Pair : (*BaselineMetrics)->Values)
+	{
+		if (!CurrentMetrics->HasField(Pair.Key))
+		{
+			OutReport += FString::Printf(TEXT("%s is in the baseline but was not recorded\n"), *Pair.Key);
+		}
+	}
+
+	return bPassed;
+}
+
+bool UNLPerfRegressionSubsystem::CompareToBaseline(FString& OutReport) const
+{
+	if (!Baseline.IsValid())
+	{
+		OutReport = FString::Printf(TEXT("%s has no metrics"), *GetBaselineFilename());
+		return false;
+	}
+
+	const TSharedRef<FJsonObject> Results = MakeResultsJson();
+
+	bool bPassed = CompareMetrics(TEXT("metrics"), { &FrameTimeMetric, &GameThreadTimeMetric, &ServerTickTimeMetric }, *Results, /*bRequireBaseline=*/ true, OutReport);
+	OutReport += TEXT("\n");
+	bPassed &= CompareMetrics(NLPerfRegression::ScopesFieldName, GetScopeMetrics(), *Results, /*bRequireBaseline=*/ false, OutReport);
+	return bPassed;
+}
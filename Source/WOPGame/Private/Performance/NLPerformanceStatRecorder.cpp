@@ -0,0 +1,299 @@
+// Copyright 2025 Noblon GmbH. All Rights Reserved.
+
+#include "NLPerformanceStatRecorder.h"
+
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Compression.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/StringBuilder.h"
+#include "NLLogChannels.h"
+
+//////////////////////////////////////////////////////////////////////
+
+namespace NLPerformanceStatRecorder
+{
+	// Uncompressed text is handed to the file (or compressor) once it grows past this, even between flushes
+	static constexpr int32 MaxTextBufferSize = 256 * 1024;
+
+	static const ANSICHAR* CSVHeader =
+		"Frame,Time,FrameMS,IdleMS,GameThreadMS,RenderThreadMS,RHIThreadMS,GPUMS,"
+		"ServerFPS,PingMS,PacketLossIn,PacketLossOut,PacketRateIn,PacketRateOut,PacketSizeIn,PacketSizeOut,Hitch\n";
+}
+
+//////////////////////////////////////////////////////////////////////
+// FNLPerformanceStatRecorder
+
+FNLPerformanceStatRecorder::FNLPerformanceStatRecorder(const FString& InBaseFilename, ENLPerformanceRecordingFormat InFormat, bool bInCompress, float InFlushInterval)
+	: BaseFilename(InBaseFilename)
+	, Format(InFormat)
+	, bCompress(bInCompress)
+	, FlushInterval(FMath::Max(InFlushInterval, 0.1f))
+{
+	Filename = BaseFilename + ((Format == ENLPerformanceRecordingFormat::CSV) ? TEXT(".csv") : TEXT(".jsonl")) + (bCompress ? TEXT(".gz") : TEXT(""));
+
+	FileWriter.Reset(IFileManager::Get().CreateFileWriter(*Filename));
+	if (!FileWriter.IsValid())
+	{
+		UE_LOG(LogNL, Error, TEXT("Failed to open performance stat recording %s"), *Filename);
+		return;
+	}
+
+	Summary.FrameTimeBuckets.SetNumZeroed(FSummary::NumFrameTimeBuckets);
+
+	if (Format == ENLPerformanceRecordingFormat::CSV)
+	{
+		TextBuffer.Append(NLPerformanceStatRecorder::CSVHeader, FCStringAnsi::Strlen(NLPerformanceStatRecorder::CSVHeader));
+	}
+
+	PendingFrames.SetNumUninitialized(PendingFramesCapacity);
+
+	WorkEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("NLPerformanceStatRecorder"), 0, TPri_BelowNormal);
+	if (Thread == nullptr)
+	{
+		UE_LOG(LogNL, Error, TEXT("Failed to create the writer thread for performance stat recording %s"), *Filename);
+
+		// Not open, so nothing gets queued for a thread that doesn't exist
+		FileWriter->Close();
+		FileWriter.Reset();
+		IFileManager::Get().Delete(*Filename);
+		return;
+	}
+
+	UE_LOG(LogNL, Log, TEXT("Recording performance stats to %s"), *Filename);
+}
+
+FNLPerformanceStatRecorder::~FNLPerformanceStatRecorder()
+{
+	if (Thread != nullptr)
+	{
+		// The thread drains everything still queued before it exits
+		Thread->Kill(/*bShouldWait=*/ true);
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (WorkEvent != nullptr)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+		WorkEvent = nullptr;
+	}
+
+	if (FileWriter.IsValid())
+	{
+		FileWriter->Close();
+		FileWriter.Reset();
+
+		WriteSummary();
+	}
+}
+
+void FNLPerformanceStatRecorder::RecordFrame(const FNLRecordedFrame& Frame)
+{
+	if (Thread == nullptr)
+	{
+		return;
+	}
+
+	const uint64 Queued = NumFramesQueued.load(std::memory_order_relaxed);
+	const uint64 NumPending = Queued - NumFramesWritten.load(std::memory_order_acquire);
+	if (NumPending >= PendingFramesCapacity)
+	{
+		++NumDroppedFrames;
+		WorkEvent->Trigger();
+		return;
+	}
+
+	PendingFrames[Queued % PendingFramesCapacity] = Frame;
+	NumFramesQueued.store(Queued + 1, std::memory_order_release);
+
+	// The writer thread wakes up on its own, only hurry it along when the ring is filling up
+	if (NumPending + 1 == PendingFramesCapacity / 2)
+	{
+		WorkEvent->Trigger();
+	}
+}
+
+uint32 FNLPerformanceStatRecorder::Run()
+{
+	double LastFlushTime = FPlatformTime::Seconds();
+
+	while (!bStopRequested.load(std::memory_order_acquire))
+	{
+		WorkEvent->Wait(FTimespan::FromMilliseconds(100.0));
+		WritePendingFrames();
+
+		const double Now = FPlatformTime::Seconds();
+		if (Now - LastFlushTime >= FlushInterval)
+		{
+			FlushTextBuffer();
+			FileWriter->Flush();
+			LastFlushTime = Now;
+		}
+	}
+
+	WritePendingFrames();
+	FlushTextBuffer();
+	FileWriter->Flush();
+
+	return 0;
+}
+
+void FNLPerformanceStatRecorder::Stop()
+{
+	bStopRequested.store(true, std::memory_order_release);
+	WorkEvent->Trigger();
+}
+
+void FNLPerformanceStatRecorder::WritePendingFrames()
+{
+	const uint64 Queued = NumFramesQueued.load(std::memory_order_acquire);
+	for (uint64 Written = NumFramesWritten.load(std::memory_order_relaxed); Written < Queued; ++Written)
+	{
+		AppendFrame(PendingFrames[Written % PendingFramesCapacity]);
+
+		// Hands the slot back to the game thread
+		NumFramesWritten.store(Written + 1, std::memory_order_release);
+
+		if (TextBuffer.Num() >= NLPerformanceStatRecorder::MaxTextBufferSize)
+		{
+			FlushTextBuffer();
+		}
+	}
+}
+
+void FNLPerformanceStatRecorder::AppendFrame(const FNLRecordedFrame& Frame)
+{
+	TAnsiStringBuilder<512> Line;
+	if (Format == ENLPerformanceRecordingFormat::CSV)
+	{
+		Line.Appendf("%llu,%.4f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.2f,%.1f,%.2f,%.2f,%.1f,%.1f,%.1f,%.1f,%d\n",
+			Frame.FrameNumber, Frame.Timestamp,
+			Frame.FrameTime * 1000.0f, Frame.IdleTime * 1000.0f, Frame.GameThreadTime * 1000.0f, Frame.RenderThreadTime * 1000.0f, Frame.RHIThreadTime * 1000.0f, Frame.GPUTime * 1000.0f,
+			Frame.ServerFPS, Frame.PingMS, Frame.PacketLossIncomingPercent, Frame.PacketLossOutgoingPercent,
+			Frame.PacketRateIncoming, Frame.PacketRateOutgoing, Frame.PacketSizeIncoming, Frame.PacketSizeOutgoing,
+			Frame.bHitch ? 1 : 0);
+	}
+	else
+	{
+		Line.Appendf("{\"frame\":%llu,\"time\":%.4f,\"frameMs\":%.3f,\"idleMs\":%.3f,\"gameThreadMs\":%.3f,\"renderThreadMs\":%.3f,\"rhiThreadMs\":%.3f,\"gpuMs\":%.3f,"
+			"\"serverFps\":%.2f,\"pingMs\":%.1f,\"packetLossIn\":%.2f,\"packetLossOut\":%.2f,\"packetRateIn\":%.1f,\"packetRateOut\":%.1f,\"packetSizeIn\":%.1f,\"packetSizeOut\":%.1f,\"hitch\":%s}\n",
+			Frame.FrameNumber, Frame.Timestamp,
+			Frame.FrameTime * 1000.0f, Frame.IdleTime * 1000.0f, Frame.GameThreadTime * 1000.0f, Frame.RenderThreadTime * 1000.0f, Frame.RHIThreadTime * 1000.0f, Frame.GPUTime * 1000.0f,
+			Frame.ServerFPS, Frame.PingMS, Frame.PacketLossIncomingPercent, Frame.PacketLossOutgoingPercent,
+			Frame.PacketRateIncoming, Frame.PacketRateOutgoing, Frame.PacketSizeIncoming, Frame.PacketSizeOutgoing,
+			Frame.bHitch ? "true" : "false");
+	}
+	TextBuffer.Append(Line.GetData(), Line.Len());
+
+	if (Summary.FirstTimestamp < 0.0)
+	{
+		Summary.FirstTimestamp = Frame.Timestamp;
+	}
+	Summary.LastTimestamp = Frame.Timestamp;
+	++Summary.NumFrames;
+	Summary.NumHitches += Frame.bHitch ? 1 : 0;
+
+	Summary.FrameTimeSum += Frame.FrameTime;
+	Summary.GameThreadTimeSum += Frame.GameThreadTime;
+	Summary.RenderThreadTimeSum += Frame.RenderThreadTime;
+	Summary.GPUTimeSum += Frame.GPUTime;
+	Summary.PingSum += Frame.PingMS;
+	Summary.PacketLossIncomingSum += Frame.PacketLossIncomingPercent;
+	Summary.PacketLossOutgoingSum += Frame.PacketLossOutgoingPercent;
+
+	Summary.MaxFrameTime = FMath::Max(Summary.MaxFrameTime, Frame.FrameTime);
+	Summary.MaxPingMS = FMath::Max(Summary.MaxPingMS, Frame.PingMS);
+
+	const int32 Bucket = FMath::Clamp(FMath::FloorToInt32(Frame.FrameTime * 1000.0f), 0, FSummary::NumFrameTimeBuckets - 1);
+	++Summary.FrameTimeBuckets[Bucket];
+}
+
+void FNLPerformanceStatRecorder::FlushTextBuffer()
+{
+	if (TextBuffer.Num() == 0)
+	{
+		return;
+	}
+
+	if (bCompress)
+	{
+		// Each chunk becomes its own gzip member, a crash loses at most the chunk in flight
+		int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Gzip, TextBuffer.Num());
+		CompressedBuffer.SetNumUninitialized(CompressedSize, EAllowShrinking::No);
+
+		if (FCompression::CompressMemory(NAME_Gzip, CompressedBuffer.GetData(), CompressedSize, TextBuffer.GetData(), TextBuffer.Num()))
+		{
+			FileWriter->Serialize(CompressedBuffer.GetData(), CompressedSize);
+			NumBytesWritten += CompressedSize;
+		}
+		else
+		{
+			UE_LOG(LogNL, Warning, TEXT("Failed to compress %d bytes of performance stats for %s, dropping them"), TextBuffer.Num(), *Filename);
+		}
+	}
+	else
+	{
+		FileWriter->Serialize(TextBuffer.GetData(), TextBuffer.Num());
+		NumBytesWritten += TextBuffer.Num();
+	}
+
+	TextBuffer.Reset();
+}
+
+void FNLPerformanceStatRecorder::WriteSummary() const
+{
+	// Percentiles are reported as the upper bounds of their 1 ms histogram buckets
+	auto GetFrameTimePercentile = [this](double Fraction)
+	{
+		const int64 TargetRank = FMath::Max<int64>(1, FMath::CeilToInt64(Fraction * Summary.NumFrames));
+
+		int64 Rank = 0;
+		for (int32 Bucket = 0; Bucket < FSummary::NumFrameTimeBuckets; ++Bucket)
+		{
+			Rank += Summary.FrameTimeBuckets[Bucket];
+			if (Rank >= TargetRank)
+			{
+				return Bucket + 1;
+			}
+		}
+		return FSummary::NumFrameTimeBuckets;
+	};
+
+	const double NumFrames = FMath::Max<double>(Summary.NumFrames, 1.0);
+	const double Duration = (Summary.NumFrames > 0) ? (Summary.LastTimestamp - Summary.FirstTimestamp) : 0.0;
+
+	TStringBuilder<2048> Report;
+	Report.Appendf(TEXT("{\n"));
+	Report.Appendf(TEXT("\t\"log\": \"%s\",\n"), *FPaths::GetCleanFilename(Filename).ReplaceCharWithEscapedChar());
+	Report.Appendf(TEXT("\t\"finished\": \"%s\",\n"), *FDateTime::UtcNow().ToIso8601());
+	Report.Appendf(TEXT("\t\"durationSeconds\": %.1f,\n"), Duration);
+	Report.Appendf(TEXT("\t\"frames\": %lld,\n"), Summary.NumFrames);
+	Report.Appendf(TEXT("\t\"hitches\": %lld,\n"), Summary.NumHitches);
+	Report.Appendf(TEXT("\t\"droppedFrames\": %lld,\n"), NumDroppedFrames);
+	Report.Appendf(TEXT("\t\"averageFps\": %.2f,\n"), (Summary.FrameTimeSum > 0.0) ? (Summary.NumFrames / Summary.FrameTimeSum) : 0.0);
+	Report.Appendf(TEXT("\t\"frameMs\": { \"mean\": %.3f, \"p50\": %d, \"p95\": %d, \"p99\": %d, \"max\": %.3f },\n"),
+		Summary.FrameTimeSum * 1000.0 / NumFrames, GetFrameTimePercentile(0.50), GetFrameTimePercentile(0.95), GetFrameTimePercentile(0.99), Summary.MaxFrameTime * 1000.0f);
+	Report.Appendf(TEXT("\t\"gameThreadMs\": %.3f,\n"), Summary.GameThreadTimeSum * 1000.0 / NumFrames);
+	Report.Appendf(TEXT("\t\"renderThreadMs\": %.3f,\n"), Summary.RenderThreadTimeSum * 1000.0 / NumFrames);
+	Report.Appendf(TEXT("\t\"gpuMs\": %.3f,\n"), Summary.GPUTimeSum * 1000.0 / NumFrames);
+	Report.Appendf(TEXT("\t\"pingMs\": { \"mean\": %.1f, \"max\": %.1f },\n"), Summary.PingSum / NumFrames, Summary.MaxPingMS);
+	Report.Appendf(TEXT("\t\"packetLossPercent\": { \"in\": %.2f, \"out\": %.2f },\n"), Summary.PacketLossIncomingSum / NumFrames, Summary.PacketLossOutgoingSum / NumFrames);
+	Report.Appendf(TEXT("\t\"bytesWritten\": %lld\n"), NumBytesWritten);
+	Report.Appendf(TEXT("}\n"));
+
+	const FString SummaryFilename = BaseFilename + TEXT("_Summary.json");
+	if (FFileHelper::SaveStringToFile(Report.ToView(), *SummaryFilename))
+	{
+		UE_LOG(LogNL, Log, TEXT("Recorded %lld frames (%lld hitches) to %s, summary written to %s"), Summary.NumFrames, Summary.NumHitches, *Filename, *SummaryFilename);
+	}
+	else
+	{
+		UE_LOG(LogNL, Warning, TEXT("Failed to write performance stat summary %s"), *SummaryFilename);
+	}
+}
@@ -0,0 +1,131 @@
+// Copyright 2025 Noblon GmbH. All Rights Reserved.
+
+#pragma once
+
+#include "HAL/Runnable.h"
+
+#include <atomic>
+
+class FArchive;
+class FEvent;
+class FRunnableThread;
+
+//////////////////////////////////////////////////////////////////////
+
+enum class ENLPerformanceRecordingFormat : uint8
+{
+	None,
+	CSV,
+	JSON,
+};
+
+// One frame worth of stats as pushed to the recorder (times in seconds)
+struct FNLRecordedFrame
+{
+	uint64 FrameNumber = 0;
+	double Timestamp = 0.0;
+
+	float FrameTime = 0.0f;
+	float IdleTime = 0.0f;
+	float GameThreadTime = 0.0f;
+	float RenderThreadTime = 0.0f;
+	float RHIThreadTime = 0.0f;
+	float GPUTime = 0.0f;
+
+	float ServerFPS = 0.0f;
+	float PingMS = 0.0f;
+	float PacketLossIncomingPercent = 0.0f;
+	float PacketLossOutgoingPercent = 0.0f;
+	float PacketRateIncoming = 0.0f;
+	float PacketRateOutgoing = 0.0f;
+	float PacketSizeIncoming = 0.0f;
+	float PacketSizeOutgoing = 0.0f;
+
+	bool bHitch = false;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+/**
+ * Streams per-frame performance stats to disk for soak tests
+ * Frames are queued without locking on the game thread, formatting, compression and file IO happen on a background thread
+ * Compressed logs are a series of gzip members, so standard tools (zcat, gunzip) read them as one file
+ * A JSON summary of the whole recording is written next to the log when the recorder is destroyed
+ */
+class FNLPerformanceStatRecorder final : public FRunnable
+{
+public:
+	// The extension of the log is picked from the format, the summary goes to <InBaseFilename>_Summary.json
+	FNLPerformanceStatRecorder(const FString& InBaseFilename, ENLPerformanceRecordingFormat InFormat, bool bInCompress, float InFlushInterval);
+	virtual ~FNLPerformanceStatRecorder() override;
+
+	bool IsOpen() const { return FileWriter.IsValid(); }
+	const FString& GetFilename() const { return Filename; }
+	ENLPerformanceRecordingFormat GetFormat() const { return Format; }
+
+	// Queues a frame for writing (game thread only)
+	void RecordFrame(const FNLRecordedFrame& Frame);
+
+	//~FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	//~End of FRunnable interface
+
+private:
+	void WritePendingFrames();
+	void AppendFrame(const FNLRecordedFrame& Frame);
+	void FlushTextBuffer();
+	void WriteSummary() const;
+
+private:
+	FString BaseFilename;
+	FString Filename;
+	ENLPerformanceRecordingFormat Format = ENLPerformanceRecordingFormat::None;
+	bool bCompress = false;
+	float FlushInterval = 1.0f;
+
+	TUniquePtr<FArchive> FileWriter;
+
+	FRunnableThread* Thread = nullptr;
+	FEvent* WorkEvent = nullptr;
+	std::atomic<bool> bStopRequested{ false };
+
+	// Preallocated ring of frames waiting for the writer thread, the game thread only advances NumFramesQueued and the writer thread only NumFramesWritten
+	// Frames that don't fit (the writer fell more than the capacity behind) are dropped and counted
+	static constexpr uint64 PendingFramesCapacity = 4096;
+	TArray<FNLRecordedFrame> PendingFrames;
+	std::atomic<uint64> NumFramesQueued{ 0 };
+	std::atomic<uint64> NumFramesWritten{ 0 };
+	int64 NumDroppedFrames = 0;
+
+	// Writer thread state
+	TArray<ANSICHAR> TextBuffer;
+	TArray<uint8> CompressedBuffer;
+
+	// Totals for the summary, accumulated by the writer thread
+	struct FSummary
+	{
+		// Frame time histogram in 1 ms buckets for the percentiles, the last bucket collects everything slower
+		static constexpr int32 NumFrameTimeBuckets = 1000;
+
+		double FirstTimestamp = -1.0;
+		double LastTimestamp = 0.0;
+		int64 NumFrames = 0;
+		int64 NumHitches = 0;
+
+		double FrameTimeSum = 0.0;
+		double GameThreadTimeSum = 0.0;
+		double RenderThreadTimeSum = 0.0;
+		double GPUTimeSum = 0.0;
+		double PingSum = 0.0;
+		double PacketLossIncomingSum = 0.0;
+		double PacketLossOutgoingSum = 0.0;
+
+		float MaxFrameTime = 0.0f;
+		float MaxPingMS = 0.0f;
+
+		TArray<uint32> FrameTimeBuckets;
+	};
+	FSummary Summary;
+	int64 NumBytesWritten = 0;
+};
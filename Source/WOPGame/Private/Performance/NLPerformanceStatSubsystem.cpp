@@ -7,6 +7,12 @@
 #include "Engine/NetConnection.h"
 #include "Engine/World.h"
 #include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "NLLogChannels.h"
+#include "NLPerformanceStatRecorder.h"
 #include "System/NLGameState.h"
 #include "Performance/NLPerformanceStatTypes.h"
 
@@ -14,9 +20,188 @@
 
 class FSubsystemCollectionBase;
 
+namespace NLPerformanceStatCVars
+{
+	static float HitchThresholdMS = 60.0f;
+	static FAutoConsoleVariableRef CVarHitchThresholdMS(
+		TEXT("NL.PerfStats.HitchThresholdMS"),
+		HitchThresholdMS,
+		TEXT("Frames taking longer than this (in milliseconds) are recorded as hitches by the performance stat subsystem."),
+		ECVF_Default);
+
+	static int32 RecordFormat = 0;
+	static FAutoConsoleVariableRef CVarRecordFormat(
+		TEXT("NL.PerfStats.Record"),
+		RecordFormat,
+		TEXT("Streams every frame's performance and net stats to Saved/Profiling/PerfStats for soak tests.\n")
+		TEXT(" 0: off (default, stopping a recording writes its summary)\n")
+		TEXT(" 1: CSV\n")
+		TEXT(" 2: JSON lines\n")
+		TEXT("Can also be enabled with -NLPerfRecord or -NLPerfRecord=json on the command line."),
+		ECVF_Default);
+
+	static bool bRecordCompressed = true;
+	static FAutoConsoleVariableRef CVarRecordCompressed(
+		TEXT("NL.PerfStats.Record.Compress"),
+		bRecordCompressed,
+		TEXT("Whether performance stat recordings are gzip compressed. Takes effect when the next recording starts."),
+		ECVF_Default);
+
+	static float RecordFlushInterval = 1.0f;
+	static FAutoConsoleVariableRef CVarRecordFlushInterval(
+		TEXT("NL.PerfStats.Record.FlushInterval"),
+		RecordFlushInterval,
+		TEXT("How often (in seconds) performance stat recordings are flushed to disk. Takes effect when the next recording starts."),
+		ECVF_Default);
+}
+
+//////////////////////////////////////////////////////////////////////
+// FNLPerformanceStatHistory
+
+const int32 FNLPerformanceStatHistory::NumBuckets = 2 + FMath::CeilToInt32(FMath::Loge(MaxTrackedValue / MinTrackedValue) / FMath::Loge(BucketGrowth));
+
+FNLPerformanceStatHistory::FNLPerformanceStatHistory()
+{
+	BucketCounts.SetNumZeroed(NumBuckets);
+}
+
+int32 FNLPerformanceStatHistory::GetBucket(double Value)
+{
+	// Bucket 0 holds zero, negative and tiny values
+	if (!(Value > MinTrackedValue))
+	{
+		return 0;
+	}
+
+	const int32 Bucket = 1 + FMath::FloorToInt32(FMath::Loge(Value / MinTrackedValue) / FMath::Loge(BucketGrowth));
+	return FMath::Min(Bucket, NumBuckets - 1);
+}
+
+double FNLPerformanceStatHistory::GetBucketValue(int32 Bucket)
+{
+	// Geometric center of the bucket
+	return (Bucket == 0) ? 0.0 : MinTrackedValue * FMath::Pow(BucketGrowth, Bucket - 0.5);
+}
+
+template <typename TPredicate>
+void FNLPerformanceStatHistory::PushExtremum(FExtremumQueue& Queue, uint64 Sequence, double Value, TPredicate ShouldReplace)
+{
+	// Drop the sample that just left the window
+	if (!Queue.IsEmpty() && (Queue.GetFront() + Capacity <= Sequence))
+	{
+		++Queue.Front;
+	}
+
+	// Samples that can never be the extremum again while the new one is in the window
+	while (!Queue.IsEmpty() && ShouldReplace(Samples[Queue.GetBack() % Capacity], Value))
+	{
+		--Queue.Back;
+	}
+
+	Queue.Sequences[Queue.Back % Capacity] = Sequence;
+	++Queue.Back;
+}
+
+void FNLPerformanceStatHistory::AddSample(double Value)
+{
+	const int32 SlotIndex = int32(NextSequence % Capacity);
+
+	if (NumSamples == Capacity)
+	{
+		const double EvictedValue = Samples[SlotIndex];
+		Sum -= EvictedValue;
+		--BucketCounts[GetBucket(EvictedValue)];
+	}
+	else
+	{
+		++NumSamples;
+	}
+
+	// The extremum queues read the new value from Samples, so write it first
+	Samples[SlotIndex] = Value;
+	Sum += Value;
+	++BucketCounts[GetBucket(Value)];
+
+	PushExtremum(MinQueue, NextSequence, Value, [](double Existing, double New) { return Existing >= New; });
+	PushExtremum(MaxQueue, NextSequence, Value, [](double Existing, double New) { return Existing <= New; });
+
+	++NextSequence;
+
+	// Rebase the running sum now and then so rounding errors don't accumulate
+	if ((NextSequence % (Capacity * 64)) == 0)
+	{
+		Sum = 0.0;
+		for (int32 Index = 0; Index < NumSamples; ++Index)
+		{
+			Sum += Samples[Index];
+		}
+	}
+}
+
+void FNLPerformanceStatHistory::Reset()
+{
+	FMemory::Memzero(BucketCounts.GetData(), BucketCounts.Num() * BucketCounts.GetTypeSize());
+	MinQueue.Front = MinQueue.Back = 0;
+	MaxQueue.Front = MaxQueue.Back = 0;
+	NextSequence = 0;
+	NumSamples = 0;
+	Sum = 0.0;
+}
+
+double FNLPerformanceStatHistory::GetLatest() const
+{
+	return (NumSamples > 0) ? Samples[(NextSequence - 1) % Capacity] : 0.0;
+}
+
+double FNLPerformanceStatHistory::GetMin() const
+{
+	return MinQueue.IsEmpty() ? 0.0 : Samples[MinQueue.GetFront() % Capacity];
+}
+
+double FNLPerformanceStatHistory::GetMax() const
+{
+	return MaxQueue.IsEmpty() ? 0.0 : Samples[MaxQueue.GetFront() % Capacity];
+}
+
+double FNLPerformanceStatHistory::GetPercentile(double Fraction) const
+{
+	if (NumSamples == 0)
+	{
+		return 0.0;
+	}
+
+	const int32 TargetRank = FMath::Clamp(FMath::CeilToInt32(Fraction * NumSamples), 1, NumSamples);
+
+	int32 Rank = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		Rank += BucketCounts[Bucket];
+		if (Rank >= TargetRank)
+		{
+			// The estimate can't be outside of what was actually seen
+			return FMath::Clamp(GetBucketValue(Bucket), GetMin(), GetMax());
+		}
+	}
+
+	return GetMax();
+}
+
+void FNLPerformanceStatHistory::GetSamples(TArray<float>& OutSamples) const
+{
+	OutSamples.Reset(NumSamples);
+	for (uint64 Sequence = NextSequence - NumSamples; Sequence < NextSequence; ++Sequence)
+	{
+		OutSamples.Add(float(Samples[Sequence % Capacity]));
+	}
+}
+
 //////////////////////////////////////////////////////////////////////
 // FNLPerformanceStatCache
 
+FNLPerformanceStatCache::~FNLPerformanceStatCache()
+{
+}
+
 void FNLPerformanceStatCache::StartCharting()
 {
 }
@@ -24,7 +209,7 @@ void FNLPerformanceStatCache::StartCharting()
 void FNLPerformanceStatCache::ProcessFrame(const FFrameData& FrameData)
 {
 	CachedData = FrameData;
-	CachedServerFPS = 0.0f;
+	CachedServerHealth = FNLServerHealth();
 	CachedPingMS = 0.0f;
 	CachedPacketLossIncomingPercent = 0.0f;
 	CachedPacketLossOutgoingPercent = 0.0f;
@@ -37,7 +222,7 @@ void FNLPerformanceStatCache::ProcessFrame(const FFrameData& FrameData)
 	{
 		if (const ANLGameState* GameState = World->GetGameState<ANLGameState>())
 		{
-			CachedServerFPS = GameState->GetServerFPS();
+			CachedServerHealth = GameState->GetServerHealth();
 		}
 
 		if (APlayerController* LocalPC = GEngine->GetFirstLocalPlayerController(World))
@@ -62,6 +247,144 @@ void FNLPerformanceStatCache::ProcessFrame(const FFrameData& FrameData)
 			}
 		}
 	}
+
+	for (ENLDisplayablePerformanceStat Stat : TEnumRange<ENLDisplayablePerformanceStat>())
+	{
+		StatHistory[(int32)Stat].AddSample(GetCachedStat(Stat));
+	}
+
+	const bool bIsHitch = (FrameData.TrueDeltaSeconds * 1000.0 > NLPerformanceStatCVars::HitchThresholdMS);
+	if (bIsHitch)
+	{
+		RecordHitch();
+	}
+
+	UpdateRecording(bIsHitch);
+
+#if NL_HITCH_CAPTURE_ENABLED
+	HitchCapture->ProcessFrame(FrameData, MySubsystem->GetGameInstance());
+#endif
+}
+
+void FNLPerformanceStatCache::UpdateRecording(bool bIsHitch)
+{
+	const ENLPerformanceRecordingFormat DesiredFormat = (ENLPerformanceRecordingFormat)FMath::Clamp(NLPerformanceStatCVars::RecordFormat, 0, (int32)ENLPerformanceRecordingFormat::JSON);
+	if (Recorder.IsValid() && (Recorder->GetFormat() != DesiredFormat))
+	{
+		StopRecording();
+	}
+
+	if (!Recorder.IsValid() && (DesiredFormat != ENLPerformanceRecordingFormat::None))
+	{
+		const FString BaseFilename = FPaths::ProfilingDir() / TEXT("PerfStats") / FString::Printf(TEXT("PerfStats_%s_%s"), IsRunningDedicatedServer() ? TEXT("Server") : TEXT("Client"), *FDateTime::Now().ToString());
+		Recorder = MakeUnique<FNLPerformanceStatRecorder>(BaseFilename, DesiredFormat, NLPerformanceStatCVars::bRecordCompressed, NLPerformanceStatCVars::RecordFlushInterval);
+
+		if (!Recorder->IsOpen())
+		{
+			// Don't retry every frame
+			Recorder.Reset();
+			NLPerformanceStatCVars::RecordFormat = 0;
+			return;
+		}
+	}
+
+	if (Recorder.IsValid())
+	{
+		FNLRecordedFrame Frame;
+		Frame.FrameNumber = GFrameCounter;
+		Frame.Timestamp = FPlatformTime::Seconds();
+		Frame.FrameTime = (float)CachedData.TrueDeltaSeconds;
+		Frame.IdleTime = (float)CachedData.IdleSeconds;
+		Frame.GameThreadTime = (float)CachedData.GameThreadTimeSeconds;
+		Frame.RenderThreadTime = (float)CachedData.RenderThreadTimeSeconds;
+		Frame.RHIThreadTime = (float)CachedData.RHIThreadTimeSeconds;
+		Frame.GPUTime = (float)CachedData.GPUTimeSeconds;
+		Frame.ServerFPS = CachedServerHealth.GetTickRate();
+		Frame.PingMS = CachedPingMS;
+		Frame.PacketLossIncomingPercent = CachedPacketLossIncomingPercent;
+		Frame.PacketLossOutgoingPercent = CachedPacketLossOutgoingPercent;
+		Frame.PacketRateIncoming = CachedPacketRateIncoming;
+		Frame.PacketRateOutgoing = CachedPacketRateOutgoing;
+		Frame.PacketSizeIncoming = CachedPacketSizeIncoming;
+		Frame.PacketSizeOutgoing = CachedPacketSizeOutgoing;
+		Frame.bHitch = bIsHitch;
+
+		Recorder->RecordFrame(Frame);
+	}
+}
+
+void FNLPerformanceStatCache::StopRecording()
+{
+	// The recorder finishes writing and produces the summary as it is destroyed
+	Recorder.Reset();
+}
+
+void FNLPerformanceStatCache::RecordHitch()
+{
+	FNLPerformanceHitch Hitch;
+	Hitch.Timestamp = FPlatformTime::Seconds();
+	Hitch.DateTime = FDateTime::UtcNow();
+	Hitch.FrameNumber = (int64)GFrameCounter;
+	Hitch.FrameTime = (float)CachedData.TrueDeltaSeconds;
+	Hitch.GameThreadTime = (float)CachedData.GameThreadTimeSeconds;
+	Hitch.RenderThreadTime = (float)CachedData.RenderThreadTimeSeconds;
+	Hitch.GPUTime = (float)CachedData.GPUTimeSeconds;
+
+	UE_LOG(LogNL, Verbose, TEXT("Hitch of %.1f ms on frame %lld (GT %.1f ms, RT %.1f ms, GPU %.1f ms)"),
+		Hitch.FrameTime * 1000.0f, Hitch.FrameNumber, Hitch.GameThreadTime * 1000.0f, Hitch.RenderThreadTime * 1000.0f, Hitch.GPUTime * 1000.0f);
+
+	if (RecentHitches.Num() < MaxRecentHitches)
+	{
+		RecentHitches.Add(Hitch);
+	}
+	else
+	{
+		RecentHitches[NumHitches % MaxRecentHitches] = Hitch;
+	}
+
+	++NumHitches;
+}
+
+FNLPerformanceStatSummary FNLPerformanceStatCache::GetStatSummary(ENLDisplayablePerformanceStat Stat) const
+{
+	FNLPerformanceStatSummary Summary;
+	if (StatHistory.IsValidIndex((int32)Stat))
+	{
+		const FNLPerformanceStatHistory& History = StatHistory[(int32)Stat];
+
+		Summary.Current = History.GetLatest();
+		Summary.Mean = History.GetMean();
+		Summary.Min = History.GetMin();
+		Summary.Max = History.GetMax();
+		Summary.P50 = History.GetPercentile(0.50);
+		Summary.P95 = History.GetPercentile(0.95);
+		Summary.P99 = History.GetPercentile(0.99);
+		Summary.NumSamples = History.Num();
+	}
+	return Summary;
+}
+
+void FNLPerformanceStatCache::GetRecentHitches(TArray<FNLPerformanceHitch>& OutHitches) const
+{
+	OutHitches.Reset(RecentHitches.Num());
+
+	// Once the ring buffer wrapped, the oldest hitch is the one that gets overwritten next
+	const int32 Oldest = (RecentHitches.Num() < MaxRecentHitches) ? 0 : int32(NumHitches % MaxRecentHitches);
+	for (int32 Index = 0; Index < RecentHitches.Num(); ++Index)
+	{
+		OutHitches.Add(RecentHitches[(Oldest + Index) % RecentHitches.Num()]);
+	}
+}
+
+void FNLPerformanceStatCache::ResetHistory()
+{
+	for (FNLPerformanceStatHistory& History : StatHistory)
+	{
+		History.Reset();
+	}
+
+	RecentHitches.Reset();
+	NumHitches = 0;
 }
 
 void FNLPerformanceStatCache::StopCharting()
@@ -70,13 +393,13 @@ void FNLPerformanceStatCache::StopCharting()
 
 double FNLPerformanceStatCache::GetCachedStat(ENLDisplayablePerformanceStat Stat) const
 {
-	static_assert((int32)ENLDisplayablePerformanceStat::Count == 15, "Need to update this function to deal with new performance stats");
+	static_assert((int32)ENLDisplayablePerformanceStat::Count == 22, "Need to update this function to deal with new performance stats");
 	switch (Stat)
 	{
 	case ENLDisplayablePerformanceStat::ClientFPS:
 		return (CachedData.TrueDeltaSeconds != 0.0) ? (1.0 / CachedData.TrueDeltaSeconds) : 0.0;
 	case ENLDisplayablePerformanceStat::ServerFPS:
-		return CachedServerFPS;
+		return CachedServerHealth.GetTickRate();
 	case ENLDisplayablePerformanceStat::IdleTime:
 		return CachedData.IdleSeconds;
 	case ENLDisplayablePerformanceStat::FrameTime:
@@ -103,6 +426,20 @@ double FNLPerformanceStatCache::GetCachedStat(ENLDisplayablePerformanceStat Stat
 		return CachedPacketSizeIncoming;
 	case ENLDisplayablePerformanceStat::PacketSize_Outgoing:
 		return CachedPacketSizeOutgoing;
+	case ENLDisplayablePerformanceStat::ServerFrameTime:
+		return CachedServerHealth.GetFrameTime();
+	case ENLDisplayablePerformanceStat::ServerFrameTime_GameThread:
+		return CachedServerHealth.GetGameThreadTime();
+	case ENLDisplayablePerformanceStat::ServerGameThreadUtilization:
+		return CachedServerHealth.GetGameThreadUtilization();
+	case ENLDisplayablePerformanceStat::ServerCPUUtilization:
+		return CachedServerHealth.GetProcessCPUUtilization();
+	case ENLDisplayablePerformanceStat::ServerConnections:
+		return CachedServerHealth.GetNumConnections();
+	case ENLDisplayablePerformanceStat::ServerReplicatedActors:
+		return CachedServerHealth.GetNumReplicatedActors();
+	case ENLDisplayablePerformanceStat::ServerBandwidth_Outgoing:
+		return CachedServerHealth.GetBandwidthOut();
 	}
 
 	return 0.0f;
@@ -115,11 +452,22 @@ void UNLPerformanceStatSubsystem::Initialize(FSubsystemCollectionBase& Collectio
 {
 	Tracker = MakeShared<FNLPerformanceStatCache>(this);
 	GEngine->AddPerformanceDataConsumer(Tracker);
+
+	FString RecordFormat;
+	if (FParse::Value(FCommandLine::Get(), TEXT("NLPerfRecord="), RecordFormat))
+	{
+		NLPerformanceStatCVars::CVarRecordFormat->Set(RecordFormat.Equals(TEXT("json"), ESearchCase::IgnoreCase) ? 2 : 1, ECVF_SetByCommandline);
+	}
+	else if (FParse::Param(FCommandLine::Get(), TEXT("NLPerfRecord")))
+	{
+		NLPerformanceStatCVars::CVarRecordFormat->Set(1, ECVF_SetByCommandline);
+	}
 }
 
 void UNLPerformanceStatSubsystem::Deinitialize()
 {
 	GEngine->RemovePerformanceDataConsumer(Tracker);
+	Tracker->StopRecording();
 	Tracker.Reset();
 }
 
@@ -128,3 +476,29 @@ double UNLPerformanceStatSubsystem::GetCachedStat(ENLDisplayablePerformanceStat
 	return Tracker->GetCachedStat(Stat);
 }
 
+FNLPerformanceStatSummary UNLPerformanceStatSubsystem::GetStatSummary(ENLDisplayablePerformanceStat Stat) const
+{
+	return Tracker->GetStatSummary(Stat);
+}
+
+void UNLPerformanceStatSubsystem::GetStatHistorySamples(ENLDisplayablePerformanceStat Stat, TArray<float>& OutSamples) const
+{
+	Tracker->GetStatHistory(Stat).GetSamples(OutSamples);
+}
+
+TArray<FNLPerformanceHitch> UNLPerformanceStatSubsystem::GetRecentHitches() const
+{
+	TArray<FNLPerformanceHitch> Hitches;
+	Tracker->GetRecentHitches(Hitches);
+	return Hitches;
+}
+
+int64 UNLPerformanceStatSubsystem::GetNumHitches() const
+{
+	return Tracker->GetNumHitches();
+}
+
+void UNLPerformanceStatSubsystem::ResetStatHistory()
+{
+	Tracker->ResetHistory();
+}
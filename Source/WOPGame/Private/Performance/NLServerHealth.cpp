@@ -0,0 +1,90 @@
+// Copyright 2025 Noblon GmbH. All Rights Reserved.
+
+#include "Performance/NLServerHealth.h"
+
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/App.h"
+#include "Net/NetworkObjectList.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(NLServerHealth)
+
+extern ENGINE_API float GAverageFPS;
+extern ENGINE_API float GAverageMS;
+
+//////////////////////////////////////////////////////////////////////
+
+namespace NLServerHealth
+{
+	static uint16 QuantizeSeconds(double Seconds)
+	{
+		return (uint16)FMath::Clamp(FMath::RoundToInt64(Seconds * 10000.0), 0, (int64)MAX_uint16);
+	}
+
+	static uint8 QuantizePercent(double Percent)
+	{
+		return (uint8)FMath::Clamp(FMath::RoundToInt32(Percent), 0, 100);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////
+// FNLServerHealth
+
+FNLServerHealth FNLServerHealth::Sample(const UWorld* World)
+{
+	using namespace NLServerHealth;
+
+	FNLServerHealth Health;
+
+	const double AverageFrameTime = GAverageMS / 1000.0;
+
+	// GGameThreadTime and the delta time both describe the previous frame, so the utilization compares matching samples
+	const double LastFrameTime = FApp::GetDeltaTime();
+	const double GameThreadTime = FPlatformTime::ToSeconds(GGameThreadTime);
+
+	Health.TickRate = (uint16)FMath::Clamp(FMath::RoundToInt32(GAverageFPS), 0, (int32)MAX_uint16);
+	Health.FrameTimeTenthsMS = QuantizeSeconds(AverageFrameTime);
+	Health.GameThreadTimeTenthsMS = QuantizeSeconds(GameThreadTime);
+	Health.IdleTimeTenthsMS = QuantizeSeconds(FApp::GetIdleTime());
+	Health.GameThreadUtilization = QuantizePercent((LastFrameTime > 0.0) ? (100.0 * GameThreadTime / LastFrameTime) : 0.0);
+	Health.ProcessCPUUtilization = QuantizePercent(FPlatformTime::GetCPUTime().CPUTimePct);
+
+	if (const UNetDriver* NetDriver = (World != nullptr) ? World->GetNetDriver() : nullptr)
+	{
+		Health.NumConnections = NetDriver->ClientConnections.Num();
+		Health.NumReplicatedActors = NetDriver->GetNetworkObjectList().GetActiveObjects().Num();
+		Health.BandwidthOutKBps = NetDriver->OutBytesPerSecond / 1024;
+	}
+
+	return Health;
+}
+
+bool FNLServerHealth::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar << TickRate;
+	Ar << GameThreadUtilization;
+	Ar << ProcessCPUUtilization;
+	Ar << FrameTimeTenthsMS;
+	Ar << GameThreadTimeTenthsMS;
+	Ar << IdleTimeTenthsMS;
+	Ar.SerializeIntPacked(NumConnections);
+	Ar.SerializeIntPacked(NumReplicatedActors);
+	Ar.SerializeIntPacked(BandwidthOutKBps);
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+bool FNLServerHealth::operator==(const FNLServerHealth& Other) const
+{
+	return (TickRate == Other.TickRate)
+		&& (GameThreadUtilization == Other.GameThreadUtilization)
+		&& (ProcessCPUUtilization == Other.ProcessCPUUtilization)
+		&& (FrameTimeTenthsMS == Other.FrameTimeTenthsMS)
+		&& (GameThreadTimeTenthsMS == Other.GameThreadTimeTenthsMS)
+		&& (IdleTimeTenthsMS == Other.IdleTimeTenthsMS)
+		&& (NumConnections == Other.NumConnections)
+		&& (NumReplicatedActors == Other.NumReplicatedActors)
+		&& (BandwidthOutKBps == Other.BandwidthOutKBps);
+}
@@ -11,6 +11,9 @@
 #include "Pawns/NLPawnExtensionComponent.h"
 #include "GameFramework/GameplayMessageSubsystem.h"
 #include "NLLogChannels.h"
+#include "Engine/ActorChannel.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
 #include "Engine/World.h"
 #include "Net/UnrealNetwork.h"
 
@@ -100,6 +103,23 @@ void ANLPlayerState::PostInitializeComponents()
 	AbilitySystemComponent->InitAbilityActorInfo(this, GetPawn());
 }
 
+void ANLPlayerState::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (TickFlushHandle.IsValid())
+	{
+		if (UNetDriver* NetDriver = GetNetDriver())
+		{
+			NetDriver->OnTickFlush().Remove(TickFlushHandle);
+		}
+		TickFlushHandle.Reset();
+	}
+
+	PendingClientMessages.Reset();
+	PendingClientMessageRelevancyChecks.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void ANLPlayerState::Reset()
 {
 	Super::Reset();
@@ -200,3 +220,117 @@ void ANLPlayerState::ClientBroadcastMessage_Implementation(const FNLVerbMessage
 		UGameplayMessageSubsystem::Get(this).BroadcastMessage(Message.Verb, Message);
 	}
 }
+
+void ANLPlayerState::QueueClientMessage(const FNLVerbMessage& Message, bool bOnlyIfRelevant)
+{
+	// Nothing to send when the owning player is local (standalone or listen server host)
+	if (!HasAuthority() || (GetNetConnection() == nullptr))
+	{
+		return;
+	}
+
+	if (!TickFlushHandle.IsValid())
+	{
+		UNetDriver* NetDriver = GetNetDriver();
+		if (NetDriver == nullptr)
+		{
+			return;
+		}
+
+		TickFlushHandle = NetDriver->OnTickFlush().AddUObject(this, &ThisClass::FlushClientMessages);
+	}
+
+	PendingClientMessages.Add(Message);
+	PendingClientMessageRelevancyChecks.Add(bOnlyIfRelevant);
+}
+
+void ANLPlayerState::FlushClientMessages(float DeltaSeconds)
+{
+	if (PendingClientMessages.Num() == 0)
+	{
+		return;
+	}
+
+	FNLVerbMessageBatch Batch;
+	Batch.Messages.Reserve(FMath::Min(PendingClientMessages.Num(), FNLVerbMessageBatch::MaxMessages));
+
+	for (int32 MessageIndex = 0; MessageIndex < PendingClientMessages.Num(); ++MessageIndex)
+	{
+		FNLVerbMessage& Message = PendingClientMessages[MessageIndex];
+		if (PendingClientMessageRelevancyChecks[MessageIndex] && !IsMessageRelevant(Message))
+		{
+			continue;
+		}
+
+		Batch.Messages.Add(MoveTemp(Message));
+		if (Batch.Messages.Num() == FNLVerbMessageBatch::MaxMessages)
+		{
+			ClientReceiveMessageBatch(Batch);
+			Batch.Messages.Reset();
+		}
+	}
+
+	if (Batch.Messages.Num() > 0)
+	{
+		ClientReceiveMessageBatch(Batch);
+	}
+
+	PendingClientMessages.Reset();
+	PendingClientMessageRelevancyChecks.Reset();
+}
+
+bool ANLPlayerState::IsMessageRelevant(const FNLVerbMessage& Message) const
+{
+	UNetConnection* Connection = GetNetConnection();
+	if (Connection == nullptr)
+	{
+		return false;
+	}
+
+	// Returns the actor a message object refers to (objects like components resolve to their owner)
+	auto GetReferencedActor = [](const UObject* Object) -> const AActor*
+	{
+		if (const AActor* Actor = Cast<AActor>(Object))
+		{
+			return Actor;
+		}
+		if (const UActorComponent* Component = Cast<UActorComponent>(Object))
+		{
+			return Component->GetOwner();
+		}
+		return nullptr;
+	};
+
+	const AActor* ReferencedActors[] = { GetReferencedActor(Message.Instigator), GetReferencedActor(Message.Target) };
+
+	bool bReferencesAnyActor = false;
+	for (const AActor* Actor : ReferencedActors)
+	{
+		if (Actor == nullptr)
+		{
+			continue;
+		}
+
+		bReferencesAnyActor = true;
+		if ((Actor == this) || Actor->bAlwaysRelevant || (Connection->FindActorChannelRef(const_cast<AActor*>(Actor)) != nullptr))
+		{
+			return true;
+		}
+	}
+
+	// Messages that are not about any actor (e.g. global announcements) are always relevant
+	return !bReferencesAnyActor;
+}
+
+void ANLPlayerState::ClientReceiveMessageBatch_Implementation(const FNLVerbMessageBatch& Batch)
+{
+	// This check is needed to prevent running the action when in standalone mode
+	if (GetNetMode() == NM_Client)
+	{
+		UGameplayMessageSubsystem& MessageSubsystem = UGameplayMessageSubsystem::Get(this);
+		for (const FNLVerbMessage& Message : Batch.Messages)
+		{
+			MessageSubsystem.BroadcastMessage(Message.Verb, Message);
+		}
+	}
+}
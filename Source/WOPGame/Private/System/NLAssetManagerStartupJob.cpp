@@ -2,9 +2,17 @@
 
 #include "System/NLAssetManagerStartupJob.h"
 #include "NLLogChannels.h"
+#include "NLStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("NLAssetManager StartupJob"), STAT_NLAssetManager_StartupJob, STATGROUP_WOPGame);
 
 TSharedPtr<FStreamableHandle> FNLAssetManagerStartupJob::DoJob() const
 {
+	NL_SCOPE_CYCLE_COUNTER(STAT_NLAssetManager_StartupJob);
+#if NL_STATS_ENABLED
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT(*JobName);
+#endif
+
 	const double JobStartTime = FPlatformTime::Seconds();
 
 	TSharedPtr<FStreamableHandle> Handle;
@@ -7,24 +7,31 @@
 #include "Player/NLPlayerState.h"
 #include "NLLogChannels.h"
 #include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(NLGameState)
 
 class APlayerState;
 
-extern ENGINE_API float GAverageFPS;
+namespace NLServerHealthCVars
+{
+	static float UpdateRate = 1.0f;
+	static FAutoConsoleVariableRef CVarUpdateRate(
+		TEXT("NL.ServerHealth.UpdateRate"),
+		UpdateRate,
+		TEXT("How often per second the server samples its load and replicates it to clients through the game state."),
+		ECVF_Default);
+}
 
 ANLGameState::ANLGameState(const FObjectInitializer& ObjectInitializer)
     : Super()
 {
-	PrimaryActorTick.bCanEverTick = true;
-	PrimaryActorTick.bStartWithTickEnabled = true;
+	// Server health is sampled on a timer, nothing needs to run every frame
+	PrimaryActorTick.bCanEverTick = false;
 
 	AbilitySystemComponent = ObjectInitializer.CreateDefaultSubobject<UNLAbilitySystemComponent>(this, TEXT("AbilitySystemComponent"));
 	AbilitySystemComponent->SetIsReplicated(true);
 	AbilitySystemComponent->SetReplicationMode(EGameplayEffectReplicationMode::Mixed);
-
-	ServerFPS = 0.0f;
 }
 
 void ANLGameState::PreInitializeComponents()
@@ -45,8 +52,20 @@ UAbilitySystemComponent* ANLGameState::GetAbilitySystemComponent() const
 	return AbilitySystemComponent;
 }
 
+void ANLGameState::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (HasAuthority())
+	{
+		UpdateServerHealth();
+	}
+}
+
 void ANLGameState::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+	GetWorldTimerManager().ClearTimer(ServerHealthTimerHandle);
+
 	Super::EndPlay(EndPlayReason);
 }
 
@@ -79,20 +98,27 @@ void ANLGameState::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLife
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	DOREPLIFETIME(ThisClass, ServerFPS);
+	FDoRepLifetimeParams SharedParams;
+	SharedParams.bIsPushBased = true;
+
+	DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, ServerHealth, SharedParams);
 }
 
-void ANLGameState::Tick(float DeltaSeconds)
+float ANLGameState::GetServerFPS() const
 {
-	Super::Tick(DeltaSeconds);
+	return ServerHealth.GetTickRate();
+}
 
-	if (GetLocalRole() == ROLE_Authority)
+void ANLGameState::UpdateServerHealth()
+{
+	const FNLServerHealth NewServerHealth = FNLServerHealth::Sample(GetWorld());
+	if (NewServerHealth != ServerHealth)
 	{
-		ServerFPS = GAverageFPS;
+		MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, ServerHealth, this);
+		ServerHealth = NewServerHealth;
 	}
-}
 
-float ANLGameState::GetServerFPS() const
-{
-	return ServerFPS;
+	// Re-armed every time so changes to the rate apply right away
+	const float UpdateInterval = 1.0f / FMath::Max(NLServerHealthCVars::UpdateRate, 0.01f);
+	GetWorldTimerManager().SetTimer(ServerHealthTimerHandle, this, &ThisClass::UpdateServerHealth, UpdateInterval, /*bLoop=*/ false);
 }
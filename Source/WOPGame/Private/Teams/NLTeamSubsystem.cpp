@@ -3,20 +3,57 @@
 #include "Teams/NLTeamSubsystem.h"
 
 #include "AbilitySystemGlobals.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
 #include "GameFramework/Controller.h"
 #include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
 #include "NLLogChannels.h"
+#include "NLStats.h"
 #include "Teams/NLTeamAgentInterface.h"
 #include "Teams/NLTeamCheats.h"
 #include "Teams/NLTeamPrivateInfo.h"
 #include "Teams/NLTeamPublicInfo.h"
 #include "Player/NLPlayerState.h"
 #include "Teams/NLTeamInfoBase.h"
+#include "TimerManager.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(NLTeamSubsystem)
 
 class FSubsystemCollectionBase;
 
+DECLARE_CYCLE_STAT(TEXT("NLTeamSubsystem FindTeamFromObject"), STAT_NLTeamSubsystem_FindTeamFromObject, STATGROUP_WOPGame);
+DECLARE_CYCLE_STAT(TEXT("NLTeamSubsystem FindTeamsForObjects"), STAT_NLTeamSubsystem_FindTeamsForObjects, STATGROUP_WOPGame);
+DECLARE_CYCLE_STAT(TEXT("NLTeamSubsystem CompareTeams"), STAT_NLTeamSubsystem_CompareTeams, STATGROUP_WOPGame);
+DECLARE_CYCLE_STAT(TEXT("NLTeamSubsystem CanCauseDamage"), STAT_NLTeamSubsystem_CanCauseDamage, STATGROUP_WOPGame);
+DECLARE_CYCLE_STAT(TEXT("NLTeamSubsystem FilterDamageableTargets"), STAT_NLTeamSubsystem_FilterDamageableTargets, STATGROUP_WOPGame);
+DECLARE_CYCLE_STAT(TEXT("NLTeamSubsystem UpdateSpatialRegistry"), STAT_NLTeamSubsystem_UpdateSpatialRegistry, STATGROUP_WOPGame);
+DECLARE_CYCLE_STAT(TEXT("NLTeamSubsystem QueryInRadius"), STAT_NLTeamSubsystem_QueryInRadius, STATGROUP_WOPGame);
+
+namespace NLTeamSubsystem
+{
+	static float SpatialUpdateRate = 10.0f;
+	static FAutoConsoleVariableRef CVarSpatialUpdateRate(
+		TEXT("NL.Teams.SpatialUpdateRate"),
+		SpatialUpdateRate,
+		TEXT("How often per second the team subsystem refreshes the member positions used by QueryTeamMembersInRadius and QueryEnemiesInRadius."),
+		ECVF_Default);
+
+	static float SpatialCellSize = 2000.0f;
+	static FAutoConsoleVariableRef CVarSpatialCellSize(
+		TEXT("NL.Teams.SpatialCellSize"),
+		SpatialCellSize,
+		TEXT("Size (in cm) of the cells of the per-team member grids, changing it rebuilds the grids on the next spatial update."),
+		ECVF_Default);
+
+	// Row/column of a team id in the relationship matrix, INDEX_NONE and ids that don't fit in a FGenericTeamId map to FGenericTeamId::NoTeam
+	static int32 GetRelationshipIndex(int32 TeamId)
+	{
+		const int32 NoTeamIndex = FGenericTeamId::NoTeam.GetId();
+		return ((TeamId >= 0) && (TeamId < NoTeamIndex)) ? TeamId : NoTeamIndex;
+	}
+}
+
 //////////////////////////////////////////////////////////////////////
 // FNLTeamTrackingInfo
 
@@ -69,6 +106,40 @@ UNLTeamSubsystem::UNLTeamSubsystem()
 {
 }
 
+void UNLTeamSubsystem::RebuildTeamRelationships()
+{
+	if (!TeamRelationships.IsValid())
+	{
+		TeamRelationships = MakeUnique<FTeamRelationshipMatrix>();
+	}
+
+	FTeamRelationshipMatrix& Matrix = *TeamRelationships;
+
+	// Only teams with a spawned team info get a fast path, any other id (including NoTeam) is compared by id
+	Matrix.RegisteredTeams = TStaticBitArray<FTeamRelationshipMatrix::NumTeamIds>();
+	for (const TPair<int32, FNLTeamTrackingInfo>& Pair : TeamMap)
+	{
+		if ((Pair.Value.PublicInfo != nullptr) || (Pair.Value.PrivateInfo != nullptr))
+		{
+			Matrix.RegisteredTeams[NLTeamSubsystem::GetRelationshipIndex(Pair.Key)] = true;
+		}
+	}
+	Matrix.RegisteredTeams[FGenericTeamId::NoTeam.GetId()] = false;
+
+	for (int32 InstigatorIndex = 0; InstigatorIndex < FTeamRelationshipMatrix::NumTeamIds; ++InstigatorIndex)
+	{
+		const bool bInstigatorRegistered = Matrix.RegisteredTeams[InstigatorIndex];
+
+		for (int32 TargetIndex = 0; TargetIndex < FTeamRelationshipMatrix::NumTeamIds; ++TargetIndex)
+		{
+			const bool bBothOnTeams = bInstigatorRegistered && Matrix.RegisteredTeams[TargetIndex];
+
+			Matrix.CanDamage[InstigatorIndex][TargetIndex] = bBothOnTeams && (InstigatorIndex != TargetIndex);
+			Matrix.Allies[InstigatorIndex][TargetIndex] = bBothOnTeams && (InstigatorIndex == TargetIndex);
+		}
+	}
+}
+
 void UNLTeamSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
 	Super::Initialize(Collection);
@@ -79,15 +150,41 @@ void UNLTeamSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 	};
 
 	CheatManagerRegistrationHandle = UCheatManager::RegisterForOnCheatManagerCreated(FOnCheatManagerCreated::FDelegate::CreateLambda(AddTeamCheats));
+
+	RebuildTeamRelationships();
 }
 
 void UNLTeamSubsystem::Deinitialize()
 {
 	UCheatManager::UnregisterFromOnCheatManagerCreated(CheatManagerRegistrationHandle);
 
+	if (UWorld* World = GetWorld())
+	{
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+		World->GetTimerManager().ClearTimer(SpatialUpdateTimerHandle);
+	}
+
+	TeamLookupCache.Reset();
+	SpatialMembers.Reset();
+	SpatialGrids.Reset();
+
 	Super::Deinitialize();
 }
 
+void UNLTeamSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Track the pawns that already exist, then every pawn spawned from now on
+	for (APawn* Pawn : TActorRange<APawn>(&InWorld))
+	{
+		SpatialMembers.Add(FSpatialMember{ Pawn });
+	}
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &ThisClass::HandleActorSpawned));
+
+	UpdateSpatialRegistry();
+}
+
 bool UNLTeamSubsystem::RegisterTeamInfo(ANLTeamInfoBase* TeamInfo)
 {
 	if (!ensure(TeamInfo))
@@ -101,6 +198,9 @@ bool UNLTeamSubsystem::RegisterTeamInfo(ANLTeamInfoBase* TeamInfo)
 		FNLTeamTrackingInfo& Entry = TeamMap.FindOrAdd(TeamId);
 		Entry.SetTeamInfo(TeamInfo);
 
+		AddToTeamLookupCache(TeamInfo, TeamId);
+		RebuildTeamRelationships();
+
 		return true;
 	}
 
@@ -123,6 +223,8 @@ bool UNLTeamSubsystem::UnregisterTeamInfo(ANLTeamInfoBase* TeamInfo)
 		if (Entry)
 		{
 			Entry->RemoveTeamInfo(TeamInfo);
+			TeamLookupCache.Remove(FObjectKey(TeamInfo));
+			RebuildTeamRelationships();
 
 			return true;
 		}
@@ -151,19 +253,49 @@ bool UNLTeamSubsystem::ChangeTeamForActor(AActor* ActorToChange, int32 NewTeamIn
 }
 
 int32 UNLTeamSubsystem::FindTeamFromObject(const UObject* TestObject) const
+{
+	NL_DETAILED_SCOPE_CYCLE_COUNTER(STAT_NLTeamSubsystem_FindTeamFromObject);
+
+	if (const int32* CachedTeamId = TeamLookupCache.Find(FObjectKey(TestObject)))
+	{
+		return *CachedTeamId;
+	}
+
+	return FindTeamFromObject_Slow(TestObject);
+}
+
+void UNLTeamSubsystem::FindTeamsForObjects(TConstArrayView<const UObject*> Objects, TArray<int32>& OutTeamIds) const
+{
+	NL_SCOPE_CYCLE_COUNTER(STAT_NLTeamSubsystem_FindTeamsForObjects);
+
+	OutTeamIds.Reset(Objects.Num());
+	for (const UObject* Object : Objects)
+	{
+		const int32* CachedTeamId = TeamLookupCache.Find(FObjectKey(Object));
+		OutTeamIds.Add(CachedTeamId ? *CachedTeamId : FindTeamFromObject_Slow(Object));
+	}
+}
+
+int32 UNLTeamSubsystem::FindTeamFromObject_Slow(const UObject* TestObject) const
 {
 	// See if it's directly a team agent
 	if (const INLTeamAgentInterface* ObjectWithTeamInterface = Cast<INLTeamAgentInterface>(TestObject))
 	{
-		return GenericTeamIdToInteger(ObjectWithTeamInterface->GetGenericTeamId());
+		return CacheTeamAgent(TestObject, ObjectWithTeamInterface);
 	}
 
 	if (const AActor* TestActor = Cast<const AActor>(TestObject))
 	{
 		// See if the instigator is a team actor
-		if (const INLTeamAgentInterface* InstigatorWithTeamInterface = Cast<INLTeamAgentInterface>(TestActor->GetInstigator()))
+		const APawn* Instigator = TestActor->GetInstigator();
+		if (const int32* CachedInstigatorTeamId = TeamLookupCache.Find(FObjectKey(Instigator)))
+		{
+			return *CachedInstigatorTeamId;
+		}
+
+		if (const INLTeamAgentInterface* InstigatorWithTeamInterface = Cast<INLTeamAgentInterface>(Instigator))
 		{
-			return GenericTeamIdToInteger(InstigatorWithTeamInterface->GetGenericTeamId());
+			return CacheTeamAgent(Instigator, InstigatorWithTeamInterface);
 		}
 
 		// TeamInfo actors don't actually have the team interface, so they need a special case
@@ -182,6 +314,49 @@ int32 UNLTeamSubsystem::FindTeamFromObject(const UObject* TestObject) const
 	return INDEX_NONE;
 }
 
+int32 UNLTeamSubsystem::CacheTeamAgent(const UObject* AgentObject, const INLTeamAgentInterface* Agent) const
+{
+	const int32 TeamId = GenericTeamIdToInteger(Agent->GetGenericTeamId());
+
+	// Agents without a team changed delegate can't be kept up to date, so they always take the slow path
+	if (FOnNLTeamIndexChangedDelegate* TeamChangedDelegate = const_cast<INLTeamAgentInterface*>(Agent)->GetOnTeamIndexChangedDelegate())
+	{
+		UNLTeamSubsystem* MutableThis = const_cast<UNLTeamSubsystem*>(this);
+		TeamChangedDelegate->AddUniqueDynamic(MutableThis, &ThisClass::HandleTeamAgentChangedTeam);
+
+		AddToTeamLookupCache(AgentObject, TeamId);
+	}
+
+	return TeamId;
+}
+
+void UNLTeamSubsystem::AddToTeamLookupCache(const UObject* Object, int32 TeamId) const
+{
+	// Destroyed objects never get looked up again (object keys include the serial number), so drop them now and then
+	if (TeamLookupCache.Num() >= TeamLookupCachePruneSize)
+	{
+		for (auto It = TeamLookupCache.CreateIterator(); It; ++It)
+		{
+			if (It.Key().ResolveObjectPtr() == nullptr)
+			{
+				It.RemoveCurrent();
+			}
+		}
+
+		TeamLookupCachePruneSize = FMath::Max(64, TeamLookupCache.Num() * 2);
+	}
+
+	TeamLookupCache.Add(FObjectKey(Object), TeamId);
+}
+
+void UNLTeamSubsystem::HandleTeamAgentChangedTeam(UObject* ObjectChangingTeam, int32 OldTeamId, int32 NewTeamId)
+{
+	if (int32* CachedTeamId = TeamLookupCache.Find(FObjectKey(ObjectChangingTeam)))
+	{
+		*CachedTeamId = NewTeamId;
+	}
+}
+
 const ANLPlayerState* UNLTeamSubsystem::FindPlayerStateFromActor(const AActor* PossibleTeamActor) const
 {
 	if (PossibleTeamActor != nullptr)
@@ -221,15 +396,31 @@ const ANLPlayerState* UNLTeamSubsystem::FindPlayerStateFromActor(const AActor* P
 
 ENLTeamComparison UNLTeamSubsystem::CompareTeams(const UObject* A, const UObject* B, int32& TeamIdA, int32& TeamIdB) const
 {
+	NL_DETAILED_SCOPE_CYCLE_COUNTER(STAT_NLTeamSubsystem_CompareTeams);
+
 	TeamIdA = FindTeamFromObject(Cast<const AActor>(A));
 	TeamIdB = FindTeamFromObject(Cast<const AActor>(B));
 
+	return CompareTeamIds(TeamIdA, TeamIdB);
+}
+
+ENLTeamComparison UNLTeamSubsystem::CompareTeamIds(int32 TeamIdA, int32 TeamIdB) const
+{
 	if ((TeamIdA == INDEX_NONE) || (TeamIdB == INDEX_NONE))
 	{
 		return ENLTeamComparison::InvalidArgument;
 	}
+
+	const int32 IndexA = NLTeamSubsystem::GetRelationshipIndex(TeamIdA);
+	const int32 IndexB = NLTeamSubsystem::GetRelationshipIndex(TeamIdB);
+
+	if (TeamRelationships->RegisteredTeams[IndexA] && TeamRelationships->RegisteredTeams[IndexB])
+	{
+		return TeamRelationships->Allies[IndexA][IndexB] ? ENLTeamComparison::OnSameTeam : ENLTeamComparison::DifferentTeams;
+	}
 	else
 	{
+		// Not registered yet (e.g. the team info hasn't replicated), or not a FGenericTeamId
 		return (TeamIdA == TeamIdB) ? ENLTeamComparison::OnSameTeam : ENLTeamComparison::DifferentTeams;
 	}
 }
@@ -344,6 +535,8 @@ TArray<int32> UNLTeamSubsystem::GetTeamIDs() const
 
 bool UNLTeamSubsystem::CanCauseDamage(const UObject* Instigator, const UObject* Target, bool bAllowDamageToSelf) const
 {
+	NL_DETAILED_SCOPE_CYCLE_COUNTER(STAT_NLTeamSubsystem_CanCauseDamage);
+
 	if (bAllowDamageToSelf)
 	{
 		if ((Instigator == Target) || (FindPlayerStateFromActor(Cast<AActor>(Instigator)) == FindPlayerStateFromActor(Cast<AActor>(Target))))
@@ -352,9 +545,46 @@ bool UNLTeamSubsystem::CanCauseDamage(const UObject* Instigator, const UObject*
 		}
 	}
 
-	int32 InstigatorTeamId;
-	int32 TargetTeamId;
-	const ENLTeamComparison Relationship = CompareTeams(Instigator, Target, /*out*/ InstigatorTeamId, /*out*/ TargetTeamId);
+	const int32 InstigatorTeamId = FindTeamFromObject(Cast<const AActor>(Instigator));
+	const int32 TargetTeamId = FindTeamFromObject(Cast<const AActor>(Target));
+	return CanTeamDamageTarget(InstigatorTeamId, TargetTeamId, Target);
+}
+
+int32 UNLTeamSubsystem::FilterDamageableTargets(const UObject* Instigator, TArrayView<AActor*> Targets, bool bAllowDamageToSelf) const
+{
+	NL_SCOPE_CYCLE_COUNTER(STAT_NLTeamSubsystem_FilterDamageableTargets);
+
+	const AActor* InstigatorActor = Cast<const AActor>(Instigator);
+	const ANLPlayerState* InstigatorPlayerState = FindPlayerStateFromActor(InstigatorActor);
+	const int32 InstigatorTeamId = FindTeamFromObject(InstigatorActor);
+
+	int32 NumDamageable = 0;
+	for (int32 Index = 0; Index < Targets.Num(); ++Index)
+	{
+		AActor* Target = Targets[Index];
+
+		const bool bIsSelf = bAllowDamageToSelf && ((Instigator == Target) || (InstigatorPlayerState == FindPlayerStateFromActor(Target)));
+		if (bIsSelf || CanTeamDamageTarget(InstigatorTeamId, FindTeamFromObject(Target), Target))
+		{
+			Swap(Targets[NumDamageable], Targets[Index]);
+			++NumDamageable;
+		}
+	}
+
+	return NumDamageable;
+}
+
+bool UNLTeamSubsystem::CanTeamDamageTarget(int32 InstigatorTeamId, int32 TargetTeamId, const UObject* Target) const
+{
+	const int32 InstigatorIndex = NLTeamSubsystem::GetRelationshipIndex(InstigatorTeamId);
+	const int32 TargetIndex = NLTeamSubsystem::GetRelationshipIndex(TargetTeamId);
+
+	if (TeamRelationships->RegisteredTeams[InstigatorIndex] && TeamRelationships->RegisteredTeams[TargetIndex])
+	{
+		return TeamRelationships->CanDamage[InstigatorIndex][TargetIndex];
+	}
+
+	const ENLTeamComparison Relationship = CompareTeamIds(InstigatorTeamId, TargetTeamId);
 	if (Relationship == ENLTeamComparison::DifferentTeams)
 	{
 		return true;
@@ -403,3 +633,175 @@ FOnNLTeamDisplayAssetChangedDelegate& UNLTeamSubsystem::GetTeamDisplayAssetChang
 	return TeamMap.FindOrAdd(TeamId).OnTeamDisplayAssetChanged;
 }
 
+void UNLTeamSubsystem::HandleActorSpawned(AActor* Actor)
+{
+	if (APawn* Pawn = Cast<APawn>(Actor))
+	{
+		// Picked up by the grids on the next spatial update
+		SpatialMembers.Add(FSpatialMember{ Pawn });
+	}
+}
+
+void UNLTeamSubsystem::UpdateSpatialRegistry()
+{
+	NL_SCOPE_CYCLE_COUNTER(STAT_NLTeamSubsystem_UpdateSpatialRegistry);
+
+	// A different cell size invalidates every cell, so everyone gets re-added below
+	const float DesiredCellSize = FMath::Max(NLTeamSubsystem::SpatialCellSize, 100.0f);
+	if (DesiredCellSize != SpatialCellSize)
+	{
+		SpatialCellSize = DesiredCellSize;
+		SpatialGrids.Reset();
+		for (FSpatialMember& Member : SpatialMembers)
+		{
+			Member.TeamId = INDEX_NONE;
+		}
+	}
+
+	for (auto It = SpatialMembers.CreateIterator(); It; ++It)
+	{
+		const int32 MemberIndex = It.GetIndex();
+		FSpatialMember& Member = *It;
+
+		const APawn* Pawn = Member.Pawn.Get();
+		if ((Pawn == nullptr) || Pawn->IsActorBeingDestroyed())
+		{
+			RemoveFromSpatialGrid(MemberIndex);
+			It.RemoveCurrent();
+			continue;
+		}
+
+		Member.Location = Pawn->GetActorLocation();
+
+		// Only members that changed team or moved to another cell touch the grids
+		const int32 TeamId = FindTeamFromObject(Pawn);
+		const FIntPoint Cell = GetSpatialCell(Member.Location);
+		if ((TeamId != Member.TeamId) || (Cell != Member.Cell))
+		{
+			RemoveFromSpatialGrid(MemberIndex);
+			Member.TeamId = TeamId;
+			Member.Cell = Cell;
+			AddToSpatialGrid(MemberIndex);
+		}
+	}
+
+	const float UpdateInterval = 1.0f / FMath::Max(NLTeamSubsystem::SpatialUpdateRate, 0.01f);
+	GetWorld()->GetTimerManager().SetTimer(SpatialUpdateTimerHandle, this, &ThisClass::UpdateSpatialRegistry, UpdateInterval, /*bLoop=*/ false);
+}
+
+FIntPoint UNLTeamSubsystem::GetSpatialCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / SpatialCellSize), FMath::FloorToInt32(Location.Y / SpatialCellSize));
+}
+
+void UNLTeamSubsystem::AddToSpatialGrid(int32 MemberIndex)
+{
+	const FSpatialMember& Member = SpatialMembers[MemberIndex];
+	if (Member.TeamId != INDEX_NONE)
+	{
+		SpatialGrids.FindOrAdd(Member.TeamId).FindOrAdd(Member.Cell).Add(MemberIndex);
+	}
+}
+
+void UNLTeamSubsystem::RemoveFromSpatialGrid(int32 MemberIndex)
+{
+	const FSpatialMember& Member = SpatialMembers[MemberIndex];
+	if (Member.TeamId == INDEX_NONE)
+	{
+		return;
+	}
+
+	if (FSpatialGrid* Grid = SpatialGrids.Find(Member.TeamId))
+	{
+		if (TArray<int32>* CellMembers = Grid->Find(Member.Cell))
+		{
+			CellMembers->RemoveSingleSwap(MemberIndex, EAllowShrinking::No);
+			if (CellMembers->IsEmpty())
+			{
+				Grid->Remove(Member.Cell);
+			}
+		}
+
+		if (Grid->IsEmpty())
+		{
+			SpatialGrids.Remove(Member.TeamId);
+		}
+	}
+}
+
+void UNLTeamSubsystem::GatherSpatialMembers(const FSpatialGrid& Grid, const FVector& Origin, float Radius, TArray<APawn*>& OutPawns) const
+{
+	const double RadiusSquared = FMath::Square((double)Radius);
+
+	auto GatherCell = [this, &Origin, RadiusSquared, &OutPawns](const TArray<int32>& CellMembers)
+	{
+		for (const int32 MemberIndex : CellMembers)
+		{
+			const FSpatialMember& Member = SpatialMembers[MemberIndex];
+			if (FVector::DistSquared(Member.Location, Origin) <= RadiusSquared)
+			{
+				// Destroyed pawns stay in the grid until the next spatial update
+				if (APawn* Pawn = Member.Pawn.Get())
+				{
+					OutPawns.Add(Pawn);
+				}
+			}
+		}
+	};
+
+	const FIntPoint MinCell = GetSpatialCell(Origin - FVector(Radius));
+	const FIntPoint MaxCell = GetSpatialCell(Origin + FVector(Radius));
+	const int64 NumCellsInRange = int64(MaxCell.X - MinCell.X + 1) * int64(MaxCell.Y - MinCell.Y + 1);
+
+	// Large radii cover more cells than are occupied, then it's cheaper to go through the occupied ones
+	if (NumCellsInRange > Grid.Num())
+	{
+		for (const TPair<FIntPoint, TArray<int32>>& Pair : Grid)
+		{
+			if ((Pair.Key.X >= MinCell.X) && (Pair.Key.X <= MaxCell.X) && (Pair.Key.Y >= MinCell.Y) && (Pair.Key.Y <= MaxCell.Y))
+			{
+				GatherCell(Pair.Value);
+			}
+		}
+	}
+	else
+	{
+		for (int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+		{
+			for (int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+			{
+				if (const TArray<int32>* CellMembers = Grid.Find(FIntPoint(CellX, CellY)))
+				{
+					GatherCell(*CellMembers);
+				}
+			}
+		}
+	}
+}
+
+void UNLTeamSubsystem::QueryTeamMembersInRadius(int32 TeamId, FVector Origin, float Radius, TArray<APawn*>& OutPawns) const
+{
+	NL_DETAILED_SCOPE_CYCLE_COUNTER(STAT_NLTeamSubsystem_QueryInRadius);
+
+	OutPawns.Reset();
+
+	if (const FSpatialGrid* Grid = SpatialGrids.Find(TeamId))
+	{
+		GatherSpatialMembers(*Grid, Origin, Radius, OutPawns);
+	}
+}
+
+void UNLTeamSubsystem::QueryEnemiesInRadius(int32 TeamId, FVector Origin, float Radius, TArray<APawn*>& OutPawns) const
+{
+	NL_DETAILED_SCOPE_CYCLE_COUNTER(STAT_NLTeamSubsystem_QueryInRadius);
+
+	OutPawns.Reset();
+
+	for (const TPair<int32, FSpatialGrid>& Pair : SpatialGrids)
+	{
+		if (CompareTeamIds(TeamId, Pair.Key) == ENLTeamComparison::DifferentTeams)
+		{
+			GatherSpatialMembers(Pair.Value, Origin, Radius, OutPawns);
+		}
+	}
+}
@@ -2,126 +2,304 @@
 
 #include "UI/IndicatorSystem/IndicatorDescriptor.h"
 
-#include "Engine/LocalPlayer.h"
+#include "Components/ActorComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/SkinnedMeshComponent.h"
+#include "GameFramework/Actor.h"
+#include "Math/VectorRegister.h"
 #include "SceneView.h"
 #include "UI/IndicatorSystem/NLIndicatorManagerComponent.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(IndicatorDescriptor)
 
-bool FIndicatorProjection::Project(const UIndicatorDescriptor& IndicatorDescriptor, const FSceneViewProjectionData& InProjectionData, const FVector2f& ScreenSize, FVector& OutScreenPositionWithDepth)
+namespace IndicatorProjection
 {
-	if (USceneComponent* Component = IndicatorDescriptor.GetSceneComponent())
+	// Pushes positions of indicators behind the camera that would land on screen out to the screen edge
+	static void PushOutBehindCamera(FVector2D& ScreenPosition, const FVector2f& ScreenSize)
 	{
-		TOptional<FVector> WorldLocation;
-		if (IndicatorDescriptor.GetComponentSocketName() != NAME_None)
+		if (FBox2f(FVector2f::Zero(), ScreenSize).IsInside((FVector2f)ScreenPosition))
 		{
-			WorldLocation = Component->GetSocketTransform(IndicatorDescriptor.GetComponentSocketName()).GetLocation();
+			const FVector2f CenterToPosition = (FVector2f(ScreenPosition) - (ScreenSize / 2)).GetSafeNormal();
+			ScreenPosition = FVector2D((ScreenSize / 2) + CenterToPosition * ScreenSize);
 		}
-		else
+	}
+}
+
+void FIndicatorBatchProjection::Reset(const FSceneViewProjectionData& InProjectionData, const FVector2f& InScreenSize)
+{
+	// Project relative to the view origin so the matrix and points fit in single precision
+	ViewOrigin = InProjectionData.ViewOrigin;
+	ViewProjectionMatrix = FMatrix44f(InProjectionData.ViewRotationMatrix * InProjectionData.ProjectionMatrix);
+	ScreenSize = InScreenSize;
+
+	Entries.Reset();
+	Results.Reset();
+	PointX.Reset();
+	PointY.Reset();
+	PointZ.Reset();
+}
+
+void FIndicatorBatchProjection::AddPoint(const FVector& WorldPoint)
+{
+	const FVector RelativePoint = WorldPoint - ViewOrigin;
+	PointX.Add(float(RelativePoint.X));
+	PointY.Add(float(RelativePoint.Y));
+	PointZ.Add(float(RelativePoint.Z));
+}
+
+FIndicatorBoundsCache::FIndicatorBoundsCache()
+{
+	RenderStateDirtyHandle = UActorComponent::MarkRenderStateDirtyEvent.AddRaw(this, &FIndicatorBoundsCache::OnRenderStateDirty);
+}
+
+FIndicatorBoundsCache::~FIndicatorBoundsCache()
+{
+	UActorComponent::MarkRenderStateDirtyEvent.Remove(RenderStateDirtyHandle);
+}
+
+FBox FIndicatorBoundsCache::GetActorBounds(const AActor& Actor, uint32 UpdateCounter)
+{
+	FEntry& Entry = Entries.FindOrAdd(&Actor);
+	Entry.LastUsed = UpdateCounter;
+
+	const FTransform RootTransform = Actor.GetActorTransform();
+	if (Entry.bDirty || Entry.bVolatile || !Entry.RootTransform.Equals(RootTransform, 0.0))
+	{
+		// Components can be added or reattached at any time, so re-check whenever cached bounds are recomputed
+		if (Entry.bDirty || !Entry.bVolatile)
 		{
-			WorldLocation = Component->GetComponentLocation();
+			Entry.bVolatile = HasVolatileBounds(Actor);
 		}
 
-		const FVector ProjectWorldLocation = WorldLocation.GetValue() + IndicatorDescriptor.GetWorldPositionOffset();
-		const EActorCanvasProjectionMode ProjectionMode = IndicatorDescriptor.GetProjectionMode();
-		
-		switch (ProjectionMode)
+		Entry.Bounds = Actor.GetComponentsBoundingBox();
+		Entry.RootTransform = RootTransform;
+		Entry.bDirty = false;
+	}
+
+	return Entry.Bounds;
+}
+
+bool FIndicatorBoundsCache::HasVolatileBounds(const AActor& Actor)
+{
+	bool bVolatile = false;
+	Actor.ForEachComponent<UPrimitiveComponent>(/*bIncludeFromChildActors=*/ false, [&Actor, &bVolatile](const UPrimitiveComponent* Component)
+	{
+		if (bVolatile || !Component->IsRegistered())
 		{
-			case EActorCanvasProjectionMode::ComponentPoint:
-			{
-				if (WorldLocation.IsSet())
-				{
-					FVector2D OutScreenSpacePosition;
-					const bool bInFrontOfCamera = ULocalPlayer::GetPixelPoint(InProjectionData, ProjectWorldLocation, OutScreenSpacePosition, &ScreenSize);
+			return;
+		}
 
-					OutScreenSpacePosition.X += IndicatorDescriptor.GetScreenSpaceOffset().X * (bInFrontOfCamera ? 1 : -1);
-					OutScreenSpacePosition.Y += IndicatorDescriptor.GetScreenSpaceOffset().Y;
+		// Skinned mesh bounds follow the pose, socket attachments follow the bones they are attached to, and components
+		// attached to another actor move with it, none of which moves our root or dirties the render state
+		const USceneComponent* AttachParent = Component->GetAttachParent();
+		bVolatile = Component->IsA<USkinnedMeshComponent>()
+			|| (Component->GetAttachSocketName() != NAME_None)
+			|| ((AttachParent != nullptr) && (AttachParent->GetOwner() != &Actor));
+	});
+	return bVolatile;
+}
 
-					if (!bInFrontOfCamera && FBox2f(FVector2f::Zero(), ScreenSize).IsInside((FVector2f)OutScreenSpacePosition))
-					{
-						const FVector2f CenterToPosition = (FVector2f(OutScreenSpacePosition) - (ScreenSize / 2)).GetSafeNormal();
-						OutScreenSpacePosition = FVector2D((ScreenSize / 2) + CenterToPosition * ScreenSize);
-					}
+void FIndicatorBoundsCache::RemoveStaleEntries(uint32 UpdateCounter, uint32 MaxAge)
+{
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if ((UpdateCounter - It.Value().LastUsed) > MaxAge)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
 
-					OutScreenPositionWithDepth = FVector(OutScreenSpacePosition.X, OutScreenSpacePosition.Y, FVector::Dist(InProjectionData.ViewOrigin, ProjectWorldLocation));
+void FIndicatorBoundsCache::OnRenderStateDirty(UActorComponent& Component)
+{
+	if (Entries.Num() > 0)
+	{
+		if (FEntry* Entry = Entries.Find(Component.GetOwner()))
+		{
+			Entry->bDirty = true;
+		}
+	}
+}
+
+bool FIndicatorBatchProjection::GatherAnchor(const UIndicatorDescriptor& IndicatorDescriptor, FIndicatorAnchor& OutAnchor, FIndicatorBoundsCache* BoundsCache, uint32 UpdateCounter)
+{
+	USceneComponent* Component = IndicatorDescriptor.GetSceneComponent();
+	if (Component == nullptr)
+	{
+		return false;
+	}
 
-					return true;
-				}
+	auto GetActorBounds = [Component, BoundsCache, UpdateCounter]()
+	{
+		const AActor* Owner = Component->GetOwner();
+		return BoundsCache ? BoundsCache->GetActorBounds(*Owner, UpdateCounter) : Owner->GetComponentsBoundingBox();
+	};
 
-				return false;
-			}
-			case EActorCanvasProjectionMode::ComponentScreenBoundingBox:
-			case EActorCanvasProjectionMode::ActorScreenBoundingBox:
-			{
-				FBox IndicatorBox;
-				if (ProjectionMode == EActorCanvasProjectionMode::ActorScreenBoundingBox)
-				{
-					IndicatorBox = Component->GetOwner()->GetComponentsBoundingBox();
-				}
-				else
-				{
-					IndicatorBox = Component->Bounds.GetBox();
-				}
-
-				FVector2D LL, UR;
-				const bool bInFrontOfCamera = ULocalPlayer::GetPixelBoundingBox(InProjectionData, IndicatorBox, LL, UR, &ScreenSize);
-			
-				const FVector& BoundingBoxAnchor = IndicatorDescriptor.GetBoundingBoxAnchor();
-				const FVector2D& ScreenSpaceOffset = IndicatorDescriptor.GetScreenSpaceOffset();
-
-				FVector ScreenPositionWithDepth;
-				ScreenPositionWithDepth.X = FMath::Lerp(LL.X, UR.X, BoundingBoxAnchor.X) + ScreenSpaceOffset.X * (bInFrontOfCamera ? 1 : -1);
-				ScreenPositionWithDepth.Y = FMath::Lerp(LL.Y, UR.Y, BoundingBoxAnchor.Y) + ScreenSpaceOffset.Y;
-				ScreenPositionWithDepth.Z = FVector::Dist(InProjectionData.ViewOrigin, ProjectWorldLocation);
-
-				const FVector2f ScreenSpacePosition = FVector2f(FVector2D(ScreenPositionWithDepth));
-				if (!bInFrontOfCamera && FBox2f(FVector2f::Zero(), ScreenSize).IsInside(ScreenSpacePosition))
-				{
-					const FVector2f CenterToPosition = (ScreenSpacePosition - (ScreenSize / 2)).GetSafeNormal();
-					const FVector2f ScreenPositionFromBehind = (ScreenSize / 2) + CenterToPosition * ScreenSize;
-					ScreenPositionWithDepth.X = ScreenPositionFromBehind.X;
-					ScreenPositionWithDepth.Y = ScreenPositionFromBehind.Y;
-				}
-				
-				OutScreenPositionWithDepth = ScreenPositionWithDepth;
-				return true;
-			}
-			case EActorCanvasProjectionMode::ActorBoundingBox:
-			case EActorCanvasProjectionMode::ComponentBoundingBox:
+	const EActorCanvasProjectionMode ProjectionMode = IndicatorDescriptor.GetProjectionMode();
+	switch (ProjectionMode)
+	{
+		case EActorCanvasProjectionMode::ComponentPoint:
+		case EActorCanvasProjectionMode::ComponentScreenBoundingBox:
+		case EActorCanvasProjectionMode::ActorScreenBoundingBox:
+		{
+			const FVector WorldLocation = (IndicatorDescriptor.GetComponentSocketName() != NAME_None) ?
+				Component->GetSocketTransform(IndicatorDescriptor.GetComponentSocketName()).GetLocation() :
+				Component->GetComponentLocation();
+
+			OutAnchor.Point = WorldLocation + IndicatorDescriptor.GetWorldPositionOffset();
+			OutAnchor.bUseScreenBox = (ProjectionMode != EActorCanvasProjectionMode::ComponentPoint);
+
+			if (OutAnchor.bUseScreenBox)
 			{
-				FBox IndicatorBox;
-				if (ProjectionMode == EActorCanvasProjectionMode::ActorBoundingBox)
-				{
-					IndicatorBox = Component->GetOwner()->GetComponentsBoundingBox();
-				}
-				else
-				{
-					IndicatorBox = Component->Bounds.GetBox();
-				}
-
-				const FVector ProjectBoxPoint = IndicatorBox.GetCenter() + (IndicatorBox.GetSize() * (IndicatorDescriptor.GetBoundingBoxAnchor() - FVector(0.5)));
-
-				FVector2D OutScreenSpacePosition;
-				const bool bInFrontOfCamera = ULocalPlayer::GetPixelPoint(InProjectionData, ProjectBoxPoint, OutScreenSpacePosition, &ScreenSize);
-				OutScreenSpacePosition.X += IndicatorDescriptor.GetScreenSpaceOffset().X * (bInFrontOfCamera ? 1 : -1);
-				OutScreenSpacePosition.Y += IndicatorDescriptor.GetScreenSpaceOffset().Y;
-
-				if (!bInFrontOfCamera && FBox2f(FVector2f::Zero(), ScreenSize).IsInside((FVector2f)OutScreenSpacePosition))
-				{
-					const FVector2f CenterToPosition = (FVector2f(OutScreenSpacePosition) - (ScreenSize / 2)).GetSafeNormal();
-					OutScreenSpacePosition = FVector2D((ScreenSize / 2) + CenterToPosition * ScreenSize);
-				}
-
-				OutScreenPositionWithDepth = FVector(OutScreenSpacePosition.X, OutScreenSpacePosition.Y, FVector::Dist(InProjectionData.ViewOrigin, ProjectBoxPoint));
-					
-				return true;
+				OutAnchor.ScreenBox = (ProjectionMode == EActorCanvasProjectionMode::ActorScreenBoundingBox) ?
+					GetActorBounds() :
+					Component->Bounds.GetBox();
 			}
+			return true;
+		}
+		case EActorCanvasProjectionMode::ActorBoundingBox:
+		case EActorCanvasProjectionMode::ComponentBoundingBox:
+		{
+			const FBox IndicatorBox = (ProjectionMode == EActorCanvasProjectionMode::ActorBoundingBox) ?
+				GetActorBounds() :
+				Component->Bounds.GetBox();
+
+			OutAnchor.Point = IndicatorBox.GetCenter() + (IndicatorBox.GetSize() * (IndicatorDescriptor.GetBoundingBoxAnchor() - FVector(0.5)));
+			OutAnchor.bUseScreenBox = false;
+			return true;
 		}
 	}
 
 	return false;
 }
 
+int32 FIndicatorBatchProjection::AddIndicator(const UIndicatorDescriptor& IndicatorDescriptor, const FIndicatorAnchor& Anchor)
+{
+	FEntry& Entry = Entries.AddDefaulted_GetRef();
+	Entry.BoundingBoxAnchor = IndicatorDescriptor.GetBoundingBoxAnchor();
+	Entry.ScreenSpaceOffset = IndicatorDescriptor.GetScreenSpaceOffset();
+
+	AddPoint(Anchor.Point);
+	Entry.FirstPoint = PointX.Num() - 1;
+
+	if (Anchor.bUseScreenBox)
+	{
+		// The depth point is only used for the distance, the corners follow it
+		Entry.FirstPoint = PointX.Num();
+		Entry.NumProjectedPoints = 8;
+		for (int32 Corner = 0; Corner < 8; ++Corner)
+		{
+			AddPoint(FVector(
+				(Corner & 1) ? Anchor.ScreenBox.Max.X : Anchor.ScreenBox.Min.X,
+				(Corner & 2) ? Anchor.ScreenBox.Max.Y : Anchor.ScreenBox.Min.Y,
+				(Corner & 4) ? Anchor.ScreenBox.Max.Z : Anchor.ScreenBox.Min.Z));
+		}
+	}
+
+	return Entries.Num() - 1;
+}
+
+void FIndicatorBatchProjection::Project()
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_FIndicatorBatchProjection_Project);
+
+	const int32 NumPoints = PointX.Num();
+
+	// Pad to a whole number of vector lanes, the padding results are never read
+	const int32 NumPaddedPoints = Align(NumPoints, 4);
+	PointX.SetNumZeroed(NumPaddedPoints, EAllowShrinking::No);
+	PointY.SetNumZeroed(NumPaddedPoints, EAllowShrinking::No);
+	PointZ.SetNumZeroed(NumPaddedPoints, EAllowShrinking::No);
+	PixelX.SetNumUninitialized(NumPaddedPoints, EAllowShrinking::No);
+	PixelY.SetNumUninitialized(NumPaddedPoints, EAllowShrinking::No);
+	PointW.SetNumUninitialized(NumPaddedPoints, EAllowShrinking::No);
+	PointDistance.SetNumUninitialized(NumPaddedPoints, EAllowShrinking::No);
+
+	const FMatrix44f& M = ViewProjectionMatrix;
+	const VectorRegister4Float M00 = VectorSetFloat1(M.M[0][0]), M10 = VectorSetFloat1(M.M[1][0]), M20 = VectorSetFloat1(M.M[2][0]), M30 = VectorSetFloat1(M.M[3][0]);
+	const VectorRegister4Float M01 = VectorSetFloat1(M.M[0][1]), M11 = VectorSetFloat1(M.M[1][1]), M21 = VectorSetFloat1(M.M[2][1]), M31 = VectorSetFloat1(M.M[3][1]);
+	const VectorRegister4Float M03 = VectorSetFloat1(M.M[0][3]), M13 = VectorSetFloat1(M.M[1][3]), M23 = VectorSetFloat1(M.M[2][3]), M33 = VectorSetFloat1(M.M[3][3]);
+
+	const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+	const VectorRegister4Float HalfWidth = VectorSetFloat1(0.5f * ScreenSize.X);
+	const VectorRegister4Float HalfHeight = VectorSetFloat1(0.5f * ScreenSize.Y);
+
+	for (int32 PointIndex = 0; PointIndex < NumPaddedPoints; PointIndex += 4)
+	{
+		const VectorRegister4Float X = VectorLoadAligned(&PointX[PointIndex]);
+		const VectorRegister4Float Y = VectorLoadAligned(&PointY[PointIndex]);
+		const VectorRegister4Float Z = VectorLoadAligned(&PointZ[PointIndex]);
+
+		// Clip space, the projection's Z is not needed
+		const VectorRegister4Float ClipX = VectorMultiplyAdd(X, M00, VectorMultiplyAdd(Y, M10, VectorMultiplyAdd(Z, M20, M30)));
+		const VectorRegister4Float ClipY = VectorMultiplyAdd(X, M01, VectorMultiplyAdd(Y, M11, VectorMultiplyAdd(Z, M21, M31)));
+		VectorRegister4Float ClipW = VectorMultiplyAdd(X, M03, VectorMultiplyAdd(Y, M13, VectorMultiplyAdd(Z, M23, M33)));
+		VectorStoreAligned(ClipW, &PointW[PointIndex]);
+
+		// Same as ULocalPlayer::GetPixelPoint: avoid dividing by zero and mirror points behind the camera
+		ClipW = VectorSelect(VectorCompareEQ(ClipW, VectorZeroFloat()), VectorOneFloat(), ClipW);
+		const VectorRegister4Float RHW = VectorReciprocalAccurate(VectorAbs(ClipW));
+
+		// Normalized device coordinates to pixels: (NDC.X * 0.5 + 0.5) * Width, (0.5 - NDC.Y * 0.5) * Height
+		const VectorRegister4Float ScreenX = VectorMultiplyAdd(VectorMultiply(ClipX, RHW), HalfWidth, HalfWidth);
+		const VectorRegister4Float ScreenY = VectorNegateMultiplyAdd(VectorMultiply(ClipY, RHW), HalfHeight, HalfHeight);
+		VectorStoreAligned(ScreenX, &PixelX[PointIndex]);
+		VectorStoreAligned(ScreenY, &PixelY[PointIndex]);
+
+		const VectorRegister4Float DistanceSquared = VectorMultiplyAdd(X, X, VectorMultiplyAdd(Y, Y, VectorMultiply(Z, Z)));
+		VectorStoreAligned(VectorSqrt(DistanceSquared), &PointDistance[PointIndex]);
+	}
+
+	// Drop the padding again so the next frame appends after the real points
+	PointX.SetNum(NumPoints, EAllowShrinking::No);
+	PointY.SetNum(NumPoints, EAllowShrinking::No);
+	PointZ.SetNum(NumPoints, EAllowShrinking::No);
+
+	Results.SetNumUninitialized(Entries.Num(), EAllowShrinking::No);
+
+	for (int32 EntryIndex = 0; EntryIndex < Entries.Num(); ++EntryIndex)
+	{
+		const FEntry& Entry = Entries[EntryIndex];
+		const int32 DepthPoint = (Entry.NumProjectedPoints == 1) ? Entry.FirstPoint : Entry.FirstPoint - 1;
+
+		FVector2D ScreenPosition;
+		bool bInFrontOfCamera;
+
+		if (Entry.NumProjectedPoints == 1)
+		{
+			ScreenPosition = FVector2D(PixelX[Entry.FirstPoint], PixelY[Entry.FirstPoint]);
+			bInFrontOfCamera = PointW[Entry.FirstPoint] >= 0.0f;
+		}
+		else
+		{
+			// Same as ULocalPlayer::GetPixelBoundingBox
+			FVector2D LL(TNumericLimits<float>::Max()), UR(TNumericLimits<float>::Lowest());
+			bInFrontOfCamera = true;
+			for (int32 PointIndex = Entry.FirstPoint; PointIndex < Entry.FirstPoint + Entry.NumProjectedPoints; ++PointIndex)
+			{
+				LL.X = FMath::Min<double>(LL.X, PixelX[PointIndex]);
+				LL.Y = FMath::Min<double>(LL.Y, PixelY[PointIndex]);
+				UR.X = FMath::Max<double>(UR.X, PixelX[PointIndex]);
+				UR.Y = FMath::Max<double>(UR.Y, PixelY[PointIndex]);
+				bInFrontOfCamera &= PointW[PointIndex] >= 0.0f;
+			}
+
+			ScreenPosition.X = FMath::Lerp(LL.X, UR.X, Entry.BoundingBoxAnchor.X);
+			ScreenPosition.Y = FMath::Lerp(LL.Y, UR.Y, Entry.BoundingBoxAnchor.Y);
+		}
+
+		ScreenPosition.X += Entry.ScreenSpaceOffset.X * (bInFrontOfCamera ? 1 : -1);
+		ScreenPosition.Y += Entry.ScreenSpaceOffset.Y;
+
+		if (!bInFrontOfCamera)
+		{
+			IndicatorProjection::PushOutBehindCamera(ScreenPosition, ScreenSize);
+		}
+
+		Results[EntryIndex] = FVector(ScreenPosition.X, ScreenPosition.Y, PointDistance[DepthPoint]);
+	}
+}
+
 void UIndicatorDescriptor::SetIndicatorManagerComponent(UNLIndicatorManagerComponent* InManager)
 {
 	// Make sure nobody has set this.
@@ -2,13 +2,34 @@
 
 #include "UI/IndicatorSystem/IndicatorLayer.h"
 
+#include "Misc/OutputDevice.h"
+#include "Styling/CoreStyle.h"
 #include "UI/IndicatorSystem/SActorCanvas.h"
+#include "UObject/UObjectIterator.h"
 #include "Widgets/Layout/SBox.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(IndicatorLayer)
 
 class SWidget;
 
+namespace IndicatorLayerCommands
+{
+	static FAutoConsoleCommandWithOutputDevice DumpPoolStatsCommand(
+		TEXT("NL.Indicators.DumpPoolStats"),
+		TEXT("Shows the widget pool statistics of every indicator layer, to tune the prewarmed widget counts."),
+		FConsoleCommandWithOutputDeviceDelegate::CreateLambda([](FOutputDevice& Ar)
+		{
+			for (TObjectIterator<UIndicatorLayer> It; It; ++It)
+			{
+				if (TSharedPtr<SActorCanvas> ActorCanvas = It->GetActorCanvas())
+				{
+					Ar.Logf(TEXT("%s:"), *It->GetPathName());
+					ActorCanvas->DumpWidgetPoolStats(Ar);
+				}
+			}
+		}));
+}
+
 /////////////////////////////////////////////////////
 // UIndicatorLayer
 
@@ -17,6 +38,8 @@ UIndicatorLayer::UIndicatorLayer(const FObjectInitializer& ObjectInitializer)
 {
 	bIsVariable = true;
 	SetVisibility(ESlateVisibility::HitTestInvisible);
+
+	ClusterFont = FCoreStyle::GetDefaultFontStyle("Bold", 14);
 }
 
 void UIndicatorLayer::ReleaseSlateResources(bool bReleaseChildren)
@@ -33,7 +56,19 @@ TSharedRef<SWidget> UIndicatorLayer::RebuildWidget()
 		ULocalPlayer* LocalPlayer = GetOwningLocalPlayer();
 		if (ensureMsgf(LocalPlayer, TEXT("Attempting to rebuild a UActorCanvas without a valid LocalPlayer!")))
 		{
-			MyActorCanvas = SNew(SActorCanvas, FLocalPlayerContext(LocalPlayer), &ArrowBrush);
+			MyActorCanvas = SNew(SActorCanvas, FLocalPlayerContext(LocalPlayer), &ArrowBrush)
+				.ClusterBrush(&ClusterBrush)
+				.ClusterFont(ClusterFont);
+
+			for (const FNLIndicatorWidgetPrewarm& Prewarm : UNLGameData::Get().PrewarmedIndicatorWidgets)
+			{
+				MyActorCanvas->PrewarmIndicatorWidgets(Prewarm.WidgetClass, Prewarm.Count);
+			}
+			for (const FNLIndicatorWidgetPrewarm& Prewarm : PrewarmedWidgets)
+			{
+				MyActorCanvas->PrewarmIndicatorWidgets(Prewarm.WidgetClass, Prewarm.Count);
+			}
+
 			return MyActorCanvas.ToSharedRef();
 		}
 	}
@@ -42,3 +77,10 @@ TSharedRef<SWidget> UIndicatorLayer::RebuildWidget()
 	return SNew(SBox);
 }
 
+void UIndicatorLayer::PrewarmIndicatorWidgets(TSoftClassPtr<UUserWidget> WidgetClass, int32 Count)
+{
+	if (MyActorCanvas.IsValid())
+	{
+		MyActorCanvas->PrewarmIndicatorWidgets(WidgetClass, Count);
+	}
+}
@@ -2,14 +2,21 @@
 
 #include "UI/IndicatorSystem/SActorCanvas.h"
 
+#include "Algo/Sort.h"
+#include "Algo/StableSort.h"
+#include "ConvexVolume.h"
 #include "Engine/GameViewportClient.h"
+#include "Framework/Application/SlateApplication.h"
 #include "UI/IndicatorSystem/IActorIndicatorWidget.h"
 #include "Layout/ArrangedChildren.h"
+#include "Misc/OutputDevice.h"
+#include "Rendering/DrawElements.h"
+#include "Fonts/FontMeasure.h"
+#include "Rendering/SlateRenderer.h"
 #include "UI/IndicatorSystem/NLIndicatorManagerComponent.h"
 #include "SceneView.h"
 #include "UI/IndicatorSystem/IndicatorDescriptor.h"
 #include "Widgets/Layout/SBox.h"
-#include "Widgets/SLeafWidget.h"
 
 class FSlateRect;
 
@@ -44,114 +51,73 @@ const FVector2D ArrowOffsets[EArrowDirection::MAX] =
 };
 
 
-class SActorCanvasArrowWidget : public SLeafWidget
+namespace NLIndicatorLOD
 {
-public:
-
-	SLATE_BEGIN_ARGS(SActorCanvasArrowWidget)
-	{}
-	/** always goes at the end */
-	SLATE_END_ARGS()
-
-	/** Ctor */
-	SActorCanvasArrowWidget()
-	: Rotation(0.0f)
-	, Arrow(nullptr)
-	{
-
-	}
-
-	/** Every widget needs one of these */
-	void Construct(const FArguments& InArgs, const FSlateBrush* ActorCanvasArrowBrush)
-	{
-		Arrow = ActorCanvasArrowBrush;
-		SetCanTick(false);
-	}
-
-	virtual int32 OnPaint(const FPaintArgs& Args,
-		const FGeometry& AllottedGeometry,
-		const FSlateRect& MyClippingRect,
-		FSlateWindowElementList& OutDrawElements,
-		int32 LayerId,
-		const FWidgetStyle& InWidgetStyle,
-		bool bParentEnabled) const override
+	static int32 MaxVisibleIndicators = 64;
+	static FAutoConsoleVariableRef CVarMaxVisibleIndicators(TEXT("NL.Indicators.MaxVisible"),
+		MaxVisibleIndicators,
+		TEXT("Maximum number of indicators shown at once, lower priority (then further away) indicators are hidden first. 0 is unlimited."),
+		ECVF_Default);
+
+	static float ReducedUpdateDistance = 3000.0f;
+	static FAutoConsoleVariableRef CVarReducedUpdateDistance(TEXT("NL.Indicators.LOD.ReducedUpdateDistance"),
+		ReducedUpdateDistance,
+		TEXT("Distance from the view beyond which automatic tier indicators refresh their world position at the reduced rate. 0 disables."),
+		ECVF_Default);
+
+	static int32 ReducedUpdateInterval = 4;
+	static FAutoConsoleVariableRef CVarReducedUpdateInterval(TEXT("NL.Indicators.LOD.ReducedUpdateInterval"),
+		ReducedUpdateInterval,
+		TEXT("Number of canvas updates between world position refreshes for reduced tier indicators."),
+		ECVF_Default);
+
+	static int32 FullRatePriority = 1;
+	static FAutoConsoleVariableRef CVarFullRatePriority(TEXT("NL.Indicators.LOD.FullRatePriority"),
+		FullRatePriority,
+		TEXT("Automatic tier indicators with at least this priority always refresh every update."),
+		ECVF_Default);
+
+	static float CullMargin = 100.0f;
+	static FAutoConsoleVariableRef CVarCullMargin(TEXT("NL.Indicators.CullMargin"),
+		CullMargin,
+		TEXT("World space margin around point indicators before they are culled as offscreen."),
+		ECVF_Default);
+
+	static float ClusterRadius = 40.0f;
+	static FAutoConsoleVariableRef CVarClusterRadius(TEXT("NL.Indicators.Cluster.Radius"),
+		ClusterRadius,
+		TEXT("Screen space radius in pixels within which indicators that allow clustering are merged. 0 disables clustering."),
+		ECVF_Default);
+
+	static float ClusterHysteresis = 1.5f;
+	static FAutoConsoleVariableRef CVarClusterHysteresis(TEXT("NL.Indicators.Cluster.Hysteresis"),
+		ClusterHysteresis,
+		TEXT("Scale on the cluster radius for indicators that were clustered last update, so they don't flicker in and out of a cluster."),
+		ECVF_Default);
+
+	static bool IsAnchorInView(const FConvexVolume& ViewFrustum, const FIndicatorAnchor& Anchor)
 	{
-		int32 MaxLayerId = LayerId;
-
-		if (Arrow)
+		if (Anchor.bUseScreenBox)
 		{
-			const bool bIsEnabled = ShouldBeEnabled(bParentEnabled);
-			const ESlateDrawEffect DrawEffects = bIsEnabled ? ESlateDrawEffect::None : ESlateDrawEffect::DisabledEffect;
-			const FColor FinalColorAndOpacity = (InWidgetStyle.GetColorAndOpacityTint() * Arrow->GetTint(InWidgetStyle)).ToFColor(true);
-
-			FSlateDrawElement::MakeRotatedBox(
-				OutDrawElements,
-				MaxLayerId++,
-				AllottedGeometry.ToPaintGeometry(Arrow->ImageSize, FSlateLayoutTransform()),
-				Arrow,
-				DrawEffects,
-				FMath::DegreesToRadians(GetRotation()),
-				TOptional<FVector2D>(),
-				FSlateDrawElement::RelativeToElement,
-				FinalColorAndOpacity
-			);
+			return ViewFrustum.IntersectBox(Anchor.ScreenBox.GetCenter(), Anchor.ScreenBox.GetExtent() + FVector(CullMargin));
 		}
 
-		return MaxLayerId;
-	}
-
-	FORCEINLINE void SetRotation(float InRotation)
-	{
-		Rotation = FMath::Fmod(InRotation, 360.0f);
-	}
-
-	FORCEINLINE float GetRotation() const
-	{
-		return Rotation;
-	}
-
-	virtual FVector2D ComputeDesiredSize(float) const override
-	{
-		if (Arrow)
-		{
-			return Arrow->ImageSize;
-		}
-		else
-		{
-			return FVector2D::ZeroVector;
-		}
+		return ViewFrustum.IntersectSphere(Anchor.Point, CullMargin);
 	}
-
-private:
-	float Rotation;
-	
-	const FSlateBrush* Arrow;
-};
+}
 
 void SActorCanvas::Construct(const FArguments& InArgs, const FLocalPlayerContext& InLocalPlayerContext, const FSlateBrush* InActorCanvasArrowBrush)
 {
 	LocalPlayerContext = InLocalPlayerContext;
 	ActorCanvasArrowBrush = InActorCanvasArrowBrush;
+	ClusterBrush = InArgs._ClusterBrush;
+	ClusterFont = InArgs._ClusterFont;
 
 	IndicatorPool.SetWorld(LocalPlayerContext.GetWorld());
 
 	SetCanTick(false);
 	SetVisibility(EVisibility::SelfHitTestInvisible);
 
-	// Create 10 arrows for starters
-	for (int32 i = 0; i < 10; ++i)
-	{
-		TSharedRef<SActorCanvasArrowWidget> ArrowWidget = SNew(SActorCanvasArrowWidget, ActorCanvasArrowBrush);
-		ArrowWidget->SetVisibility(EVisibility::Collapsed);
-		
-		ArrowChildren.AddSlot(MoveTemp(
-			FArrowSlot::FSlotArguments(MakeUnique<FArrowSlot>())
-			[
-				ArrowWidget
-			]
-		));
-	}
-
 	UpdateActiveTimer();
 }
 
@@ -202,6 +168,14 @@ EActiveTimerReturnType SActorCanvas::UpdateCanvas(double InCurrentTime, float In
 
 			bool IndicatorsChanged = false;
 
+			BatchProjection.Reset(ProjectionData, PaintGeometry.Size);
+			ProjectedChildIndices.Reset();
+			++UpdateCounter;
+
+			FConvexVolume ViewFrustum;
+			GetViewFrustumBounds(ViewFrustum, ProjectionData.ComputeViewProjectionMatrix(), /*bUseNearPlane=*/ true);
+
+			// Gather the anchor points of every visible indicator so they can be projected together
 			for (int32 ChildIndex = 0; ChildIndex < CanvasChildren.Num(); ++ChildIndex)
 			{
 				SActorCanvas::FSlot& CurChild = CanvasChildren[ChildIndex];
@@ -235,12 +209,15 @@ EActiveTimerReturnType SActorCanvas::UpdateCanvas(double InCurrentTime, float In
 					IndicatorsChanged = true;
 				}
 
-				FVector ScreenPositionWithDepth;
-
-				FIndicatorProjection Projector;
-				const bool Success = Projector.Project(*Indicator, ProjectionData, PaintGeometry.Size, OUT ScreenPositionWithDepth);
+				if (ShouldRefreshAnchor(CurChild, ProjectionData.ViewOrigin))
+				{
+					CurChild.bHasAnchor = FIndicatorBatchProjection::GatherAnchor(*Indicator, CurChild.Anchor, &BoundsCache, UpdateCounter);
+					CurChild.LastAnchorUpdate = UpdateCounter;
+				}
 
-				if (!Success)
+				// Skip the projection of indicators that can't be projected, or are outside the view and don't need to be clamped to the screen edge
+				const bool bCanCull = !Indicator->GetClampToScreen() && Indicator->GetCullWhenOffscreen();
+				if (!CurChild.bHasAnchor || (bCanCull && !NLIndicatorLOD::IsAnchorInView(ViewFrustum, CurChild.Anchor)))
 				{
 					CurChild.SetHasValidScreenPosition(false);
 					CurChild.SetInFrontOfCamera(false);
@@ -250,18 +227,46 @@ EActiveTimerReturnType SActorCanvas::UpdateCanvas(double InCurrentTime, float In
 					continue;
 				}
 
-				CurChild.SetInFrontOfCamera(Success);
+				BatchProjection.AddIndicator(*Indicator, CurChild.Anchor);
+
+				// Removals only ever happen at or after the current index, so gathered indices stay valid
+				ProjectedChildIndices.Add(ChildIndex);
+			}
+
+			BatchProjection.Project();
+
+			// Actors no indicator asked about for a while most likely lost their indicators
+			if ((UpdateCounter % 64) == 0)
+			{
+				BoundsCache.RemoveStaleEntries(UpdateCounter, 64);
+			}
+
+			for (int32 ResultIndex = 0; ResultIndex < ProjectedChildIndices.Num(); ++ResultIndex)
+			{
+				SActorCanvas::FSlot& CurChild = CanvasChildren[ProjectedChildIndices[ResultIndex]];
+				UIndicatorDescriptor* Indicator = CurChild.Indicator;
+
+				const FVector& ScreenPositionWithDepth = BatchProjection.GetScreenPositionWithDepth(ResultIndex);
+
+				CurChild.SetInFrontOfCamera(true);
 				CurChild.SetHasValidScreenPosition(CurChild.GetInFrontOfCamera() || Indicator->GetClampToScreen());
 
 				if (CurChild.HasValidScreenPosition())
 				{
 					// Only dirty the screen position if we can actually show this indicator.
 					CurChild.SetScreenPosition(FVector2D(ScreenPositionWithDepth));
-					CurChild.SetDepth(ScreenPositionWithDepth.X);
+					CurChild.SetDepth(ScreenPositionWithDepth.Z);
 				}
 
 				CurChild.SetPriority(Indicator->GetPriority());
+			}
 
+			UpdateClusters(PaintGeometry.Size);
+			ApplyVisibilityBudget(PaintGeometry.Size);
+
+			for (int32 ChildIndex : ProjectedChildIndices)
+			{
+				SActorCanvas::FSlot& CurChild = CanvasChildren[ChildIndex];
 				IndicatorsChanged |= CurChild.bIsDirty();
 				CurChild.ClearDirtyFlag();
 			}
@@ -292,6 +297,154 @@ EActiveTimerReturnType SActorCanvas::UpdateCanvas(double InCurrentTime, float In
 	}
 }
 
+bool SActorCanvas::ShouldRefreshAnchor(const FSlot& Slot, const FVector& ViewOrigin) const
+{
+	if (!Slot.bHasAnchor)
+	{
+		return true;
+	}
+
+	const UIndicatorDescriptor* Indicator = Slot.Indicator;
+
+	EIndicatorUpdateTier UpdateTier = Indicator->GetUpdateTier();
+	if (UpdateTier == EIndicatorUpdateTier::Automatic)
+	{
+		const bool bFarAway = (NLIndicatorLOD::ReducedUpdateDistance > 0.0f) && (FVector::DistSquared(ViewOrigin, Slot.Anchor.Point) > FMath::Square(NLIndicatorLOD::ReducedUpdateDistance));
+		UpdateTier = (bFarAway && Indicator->GetPriority() < NLIndicatorLOD::FullRatePriority) ? EIndicatorUpdateTier::Reduced : EIndicatorUpdateTier::EveryFrame;
+	}
+
+	switch (UpdateTier)
+	{
+		case EIndicatorUpdateTier::Reduced:
+			return (UpdateCounter - Slot.LastAnchorUpdate) >= uint32(FMath::Max(NLIndicatorLOD::ReducedUpdateInterval, 1));
+		case EIndicatorUpdateTier::Frozen:
+			return false;
+		default:
+			return true;
+	}
+}
+
+void SActorCanvas::UpdateClusters(const FVector2f& ScreenSize)
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_SActorCanvas_UpdateClusters);
+
+	Clusters.Reset();
+	ClusterCells.Reset();
+	NextClusterMember.SetNumUninitialized(CanvasChildren.Num(), EAllowShrinking::No);
+
+	const float Radius = NLIndicatorLOD::ClusterRadius;
+	if (Radius <= 0.0f)
+	{
+		for (int32 ChildIndex : ProjectedChildIndices)
+		{
+			CanvasChildren[ChildIndex].SetIsClustered(false);
+		}
+		return;
+	}
+
+	const FBox2f ScreenBox(FVector2f::Zero(), ScreenSize);
+	const float InvCellSize = 1.0f / Radius;
+
+	// Greedy clustering on a spatial hash with cells the size of the radius, a cluster only has to be looked for in the cells within the join radius
+	for (int32 ChildIndex : ProjectedChildIndices)
+	{
+		SActorCanvas::FSlot& CurChild = CanvasChildren[ChildIndex];
+		const UIndicatorDescriptor* Indicator = CurChild.Indicator;
+		const FVector2f ScreenPosition = FVector2f(CurChild.GetScreenPosition());
+
+		if (!Indicator->GetAllowClustering() || !CurChild.HasValidScreenPosition() || !ScreenBox.IsInside(ScreenPosition))
+		{
+			CurChild.SetIsClustered(false);
+			continue;
+		}
+
+		const UClass* WidgetClass = Indicator->IndicatorWidget.IsValid() ? Indicator->IndicatorWidget->GetClass() : nullptr;
+
+		// Indicators that were clustered stay in with a larger radius
+		const float JoinRadius = CurChild.IsClustered() ? Radius * FMath::Max(NLIndicatorLOD::ClusterHysteresis, 1.0f) : Radius;
+		const float JoinRadiusSquared = FMath::Square(JoinRadius);
+
+		const FIntPoint Cell(FMath::FloorToInt32(ScreenPosition.X * InvCellSize), FMath::FloorToInt32(ScreenPosition.Y * InvCellSize));
+		const int32 CellReach = FMath::CeilToInt32(JoinRadius * InvCellSize);
+
+		int32 JoinedCluster = INDEX_NONE;
+		for (int32 CellY = Cell.Y - CellReach; CellY <= Cell.Y + CellReach && JoinedCluster == INDEX_NONE; ++CellY)
+		{
+			for (int32 CellX = Cell.X - CellReach; CellX <= Cell.X + CellReach && JoinedCluster == INDEX_NONE; ++CellX)
+			{
+				const int32* FirstCluster = ClusterCells.Find(FIntPoint(CellX, CellY));
+				for (int32 ClusterIndex = FirstCluster ? *FirstCluster : INDEX_NONE; ClusterIndex != INDEX_NONE; ClusterIndex = Clusters[ClusterIndex].NextInCell)
+				{
+					const FIndicatorCluster& Cluster = Clusters[ClusterIndex];
+					if (Cluster.WidgetClass == WidgetClass && FVector2f::DistSquared(Cluster.Seed, ScreenPosition) <= JoinRadiusSquared)
+					{
+						JoinedCluster = ClusterIndex;
+						break;
+					}
+				}
+			}
+		}
+
+		if (JoinedCluster == INDEX_NONE)
+		{
+			int32& CellHead = ClusterCells.FindOrAdd(Cell, INDEX_NONE);
+			JoinedCluster = Clusters.Add({ ScreenPosition, FVector2f::ZeroVector, WidgetClass, INDEX_NONE, 0, CellHead });
+			CellHead = JoinedCluster;
+		}
+
+		FIndicatorCluster& Cluster = Clusters[JoinedCluster];
+		Cluster.PositionSum += ScreenPosition;
+		NextClusterMember[ChildIndex] = Cluster.FirstMember;
+		Cluster.FirstMember = ChildIndex;
+		++Cluster.NumMembers;
+	}
+
+	// Only clusters of two or more replace their indicators
+	for (const FIndicatorCluster& Cluster : Clusters)
+	{
+		for (int32 ChildIndex = Cluster.FirstMember; ChildIndex != INDEX_NONE; ChildIndex = NextClusterMember[ChildIndex])
+		{
+			CanvasChildren[ChildIndex].SetIsClustered(Cluster.NumMembers > 1);
+		}
+	}
+}
+
+void SActorCanvas::ApplyVisibilityBudget(const FVector2f& ScreenSize)
+{
+	const FBox2f ScreenBox(FVector2f::Zero(), ScreenSize);
+
+	// Only indicators that would actually show compete for the budget
+	BudgetCandidates.Reset();
+	for (int32 ChildIndex : ProjectedChildIndices)
+	{
+		SActorCanvas::FSlot& CurChild = CanvasChildren[ChildIndex];
+		CurChild.SetIsWithinBudget(true);
+
+		if (CurChild.HasValidScreenPosition() && !CurChild.IsClustered() && (CurChild.Indicator->GetClampToScreen() || ScreenBox.IsInside(FVector2f(CurChild.GetScreenPosition()))))
+		{
+			BudgetCandidates.Add(ChildIndex);
+		}
+	}
+
+	const int32 MaxVisible = NLIndicatorLOD::MaxVisibleIndicators;
+	if ((MaxVisible <= 0) || (BudgetCandidates.Num() <= MaxVisible))
+	{
+		return;
+	}
+
+	Algo::Sort(BudgetCandidates, [this](int32 A, int32 B)
+	{
+		const SActorCanvas::FSlot& SlotA = CanvasChildren[A];
+		const SActorCanvas::FSlot& SlotB = CanvasChildren[B];
+		return SlotA.GetPriority() == SlotB.GetPriority() ? SlotA.GetDepth() < SlotB.GetDepth() : SlotA.GetPriority() > SlotB.GetPriority();
+	});
+
+	for (int32 CandidateIndex = MaxVisible; CandidateIndex < BudgetCandidates.Num(); ++CandidateIndex)
+	{
+		CanvasChildren[BudgetCandidates[CandidateIndex]].SetIsWithinBudget(false);
+	}
+}
+
 void SActorCanvas::SetShowAnyIndicators(bool bIndicators)
 {
 	if (bShowAnyIndicators != bIndicators)
@@ -300,10 +453,15 @@ void SActorCanvas::SetShowAnyIndicators(bool bIndicators)
 
 		if (!bShowAnyIndicators)
 		{
-			for (int32 ChildIndex = 0; ChildIndex < AllChildren.Num(); ChildIndex++)
+			for (int32 ChildIndex = 0; ChildIndex < CanvasChildren.Num(); ChildIndex++)
 			{
-				AllChildren.GetChildAt(ChildIndex)->SetVisibility(EVisibility::Collapsed);
+				CanvasChildren.GetChildAt(ChildIndex)->SetVisibility(EVisibility::Collapsed);
 			}
+
+			// Badges and arrows are drawn by OnPaint itself, so they have to go as well
+			Clusters.Reset();
+			Arrows.Reset();
+			Invalidate(EInvalidateWidget::Paint);
 		}
 	}
 }
@@ -312,7 +470,7 @@ void SActorCanvas::OnArrangeChildren(const FGeometry& AllottedGeometry, FArrange
 {
 	QUICK_SCOPE_CYCLE_COUNTER(STAT_SActorCanvas_OnArrangeChildren);
 
-	NextArrowIndex = 0;
+	Arrows.Reset();
 
 	//Make sure we have a player. If we don't, we can't project anything
 	if (bShowAnyIndicators)
@@ -321,23 +479,13 @@ void SActorCanvas::OnArrangeChildren(const FGeometry& AllottedGeometry, FArrange
 		const FIntPoint FixedPadding = FIntPoint(10.0f, 10.0f) + FIntPoint(ArrowWidgetSize.X, ArrowWidgetSize.Y);
 		const FVector Center = FVector(AllottedGeometry.Size * 0.5f, 0.0f);
 
-		// Sort the children
-		TArray<const SActorCanvas::FSlot*> SortedSlots;
-		for (int32 ChildIndex = 0; ChildIndex < CanvasChildren.Num(); ++ChildIndex)
-		{
-			SortedSlots.Add(&CanvasChildren[ChildIndex]);
-		}
-
-		SortedSlots.StableSort([](const SActorCanvas::FSlot& A, const SActorCanvas::FSlot& B)
-		{
-			return A.GetPriority() == B.GetPriority() ? A.GetDepth() > B.GetDepth() : A.GetPriority() < B.GetPriority();
-		});
+		UpdateSlotOrder();
 
 		// Go through all the sorted children
-		for (int32 ChildIndex = 0; ChildIndex < SortedSlots.Num(); ++ChildIndex)
+		for (int32 SortedIndex = 0; SortedIndex < SortedSlotIndices.Num(); ++SortedIndex)
 		{
 			//grab a child
-			const SActorCanvas::FSlot& CurChild = *SortedSlots[ChildIndex];
+			const SActorCanvas::FSlot& CurChild = CanvasChildren[SortedSlotIndices[SortedIndex]];
 			const UIndicatorDescriptor* Indicator = CurChild.Indicator;
 
 			// Skip this indicator if it's invalid or has an invalid world position
@@ -428,19 +576,11 @@ void SActorCanvas::OnArrangeChildren(const FGeometry& AllottedGeometry, FArrange
 
 				// should we show an arrow
 				if (Indicator->GetShowClampToScreenArrow() &&
-					bWasIndicatorClamped &&
-					ArrowChildren.IsValidIndex(NextArrowIndex))
+					bWasIndicatorClamped)
 				{
 					const FVector2D ArrowOffsetDirection = ArrowOffsets[ClampDir];
 					const float ArrowRotation = ArrowRotations[ClampDir];
 
-					//grab an arrow widget
-					TSharedRef<SActorCanvasArrowWidget> ArrowWidgetToUse = StaticCastSharedRef<SActorCanvasArrowWidget>(ArrowChildren.GetChildAt(NextArrowIndex));
-					NextArrowIndex++;
-
-					//set the rotation of the arrow
-					ArrowWidgetToUse->SetRotation(ArrowRotation);
-
 					//figure out the magnitude of the offset
 					const FVector2D OffsetMagnitude = (SlotSize + ArrowWidgetSize) * 0.5f;
 
@@ -466,15 +606,8 @@ void SActorCanvas::OnArrangeChildren(const FGeometry& AllottedGeometry, FArrange
 					//get the final position
 					const FVector2D FinalPosition = (ScreenPosition + FinalOffset);
 
-					ArrowWidgetToUse->SetVisibility(EVisibility::HitTestInvisible);
-
-					// Inject the arrow on top of the indicator
-					ArrangedChildren.AddWidget(AllottedGeometry.MakeChild(
-						ArrowWidgetToUse,			// The child widget being arranged
-						FinalPosition,				// Child's local position (i.e. position within parent)
-						ArrowWidgetSize,			// Child's size
-						1.f							// Child's scale
-					));
+					// Arrows are drawn together in OnPaint, on top of the indicators
+					Arrows.Add({ FVector2f(FinalPosition), FMath::DegreesToRadians(ArrowRotation) });
 				}
 			}
 
@@ -490,15 +623,68 @@ void SActorCanvas::OnArrangeChildren(const FGeometry& AllottedGeometry, FArrange
 		}
 	}
 
-	if (NextArrowIndex < ArrowIndexLastUpdate)
+}
+
+void SActorCanvas::UpdateSlotOrder() const
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_SActorCanvas_UpdateSlotOrder);
+
+	bool bNeedsSort = false;
+
+	// Slots are normally tracked as they are added and removed, start over if we lost track
+	if (SortedSlotIndices.Num() != CanvasChildren.Num())
 	{
-		for (int32 ArrowRemovedIndex = NextArrowIndex; ArrowRemovedIndex < ArrowIndexLastUpdate; ArrowRemovedIndex++)
+		SortedSlotIndices.Reset();
+		for (int32 ChildIndex = 0; ChildIndex < CanvasChildren.Num(); ++ChildIndex)
 		{
-			ArrowChildren.GetChildAt(ArrowRemovedIndex)->SetVisibility(EVisibility::Collapsed);
+			SortedSlotIndices.Add(ChildIndex);
 		}
+		bNeedsSort = true;
+	}
+
+	for (int32 ChildIndex = 0; ChildIndex < CanvasChildren.Num(); ++ChildIndex)
+	{
+		const SActorCanvas::FSlot& Slot = CanvasChildren[ChildIndex];
+		bNeedsSort |= Slot.bSortKeyDirty;
+		Slot.bSortKeyDirty = false;
 	}
 
-	ArrowIndexLastUpdate = NextArrowIndex;
+	if (!bNeedsSort)
+	{
+		return;
+	}
+
+	auto IsBefore = [this](int32 A, int32 B)
+	{
+		const SActorCanvas::FSlot& SlotA = CanvasChildren[A];
+		const SActorCanvas::FSlot& SlotB = CanvasChildren[B];
+		return SlotA.GetPriority() == SlotB.GetPriority() ? SlotA.GetDepth() > SlotB.GetDepth() : SlotA.GetPriority() < SlotB.GetPriority();
+	};
+
+	// The previous order is usually close, so an insertion sort is close to linear. It is stable and works in place.
+	// If it turns out that most things moved (e.g. the camera turned around) fall back to a regular sort.
+	const int32 MaxShifts = SortedSlotIndices.Num() * 8;
+	int32 NumShifts = 0;
+
+	for (int32 SortedIndex = 1; SortedIndex < SortedSlotIndices.Num(); ++SortedIndex)
+	{
+		const int32 ChildIndex = SortedSlotIndices[SortedIndex];
+
+		int32 InsertIndex = SortedIndex;
+		while (InsertIndex > 0 && IsBefore(ChildIndex, SortedSlotIndices[InsertIndex - 1]))
+		{
+			SortedSlotIndices[InsertIndex] = SortedSlotIndices[InsertIndex - 1];
+			--InsertIndex;
+		}
+		SortedSlotIndices[InsertIndex] = ChildIndex;
+
+		NumShifts += SortedIndex - InsertIndex;
+		if (NumShifts > MaxShifts)
+		{
+			Algo::StableSort(SortedSlotIndices, IsBefore);
+			break;
+		}
+	}
 }
 
 int32 SActorCanvas::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
@@ -530,9 +716,128 @@ int32 SActorCanvas::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeo
 		}
 	}
 
+	if (bShowAnyIndicators && (Clusters.Num() > 0))
+	{
+		MaxLayerId = PaintClusters(AllottedGeometry, OutDrawElements, MaxLayerId + 1, InWidgetStyle, bShouldBeEnabled);
+	}
+
+	if (bShowAnyIndicators && (Arrows.Num() > 0))
+	{
+		MaxLayerId = PaintArrows(AllottedGeometry, OutDrawElements, MaxLayerId + 1, InWidgetStyle, bShouldBeEnabled);
+	}
+
 	return MaxLayerId;
 }
 
+int32 SActorCanvas::PaintClusters(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bEnabled) const
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_SActorCanvas_PaintClusters);
+
+	const ESlateDrawEffect DrawEffects = bEnabled ? ESlateDrawEffect::None : ESlateDrawEffect::DisabledEffect;
+	const TSharedRef<FSlateFontMeasure> FontMeasure = FSlateApplication::Get().GetRenderer()->GetFontMeasureService();
+	const FLinearColor TextColor = InWidgetStyle.GetColorAndOpacityTint() * InWidgetStyle.GetForegroundColor();
+
+	for (const FIndicatorCluster& Cluster : Clusters)
+	{
+		if (Cluster.NumMembers < 2)
+		{
+			continue;
+		}
+
+		const FVector2f Center = Cluster.PositionSum / float(Cluster.NumMembers);
+		const FString CountText = FString::FromInt(Cluster.NumMembers);
+		const FVector2f TextSize = FVector2f(FontMeasure->Measure(CountText, ClusterFont));
+
+		if (ClusterBrush && ClusterBrush->DrawAs != ESlateBrushDrawType::NoDrawType)
+		{
+			const FVector2f BadgeSize = FVector2f::Max(FVector2f(ClusterBrush->GetImageSize()), TextSize);
+			FSlateDrawElement::MakeBox(
+				OutDrawElements,
+				LayerId,
+				AllottedGeometry.ToPaintGeometry(BadgeSize, FSlateLayoutTransform(Center - BadgeSize * 0.5f)),
+				ClusterBrush,
+				DrawEffects,
+				InWidgetStyle.GetColorAndOpacityTint() * ClusterBrush->GetTint(InWidgetStyle));
+		}
+
+		FSlateDrawElement::MakeText(
+			OutDrawElements,
+			LayerId + 1,
+			AllottedGeometry.ToPaintGeometry(TextSize, FSlateLayoutTransform(Center - TextSize * 0.5f)),
+			CountText,
+			ClusterFont,
+			DrawEffects,
+			TextColor);
+	}
+
+	return LayerId + 1;
+}
+
+int32 SActorCanvas::PaintArrows(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bEnabled) const
+{
+	QUICK_SCOPE_CYCLE_COUNTER(STAT_SActorCanvas_PaintArrows);
+
+	if ((ActorCanvasArrowBrush == nullptr) || (ActorCanvasArrowBrush->DrawAs == ESlateBrushDrawType::NoDrawType))
+	{
+		return LayerId;
+	}
+
+	const FSlateResourceHandle ArrowResource = FSlateApplication::Get().GetRenderer()->GetResourceHandle(*ActorCanvasArrowBrush);
+	const FSlateShaderResourceProxy* ArrowResourceProxy = ArrowResource.GetResourceProxy();
+	if (ArrowResourceProxy == nullptr)
+	{
+		return LayerId;
+	}
+
+	const FVector2f ArrowSize = FVector2f(ActorCanvasArrowBrush->GetImageSize());
+	const FVector2f HalfArrowSize = ArrowSize * 0.5f;
+	const FVector2f StartUV = ArrowResourceProxy->StartUV;
+	const FVector2f SizeUV = ArrowResourceProxy->SizeUV;
+	const FColor ArrowColor = (InWidgetStyle.GetColorAndOpacityTint() * ActorCanvasArrowBrush->GetTint(InWidgetStyle)).ToFColor(true);
+	const FSlateRenderTransform& RenderTransform = AllottedGeometry.GetAccumulatedRenderTransform();
+
+	static const FVector2f CornerUVs[4] = { FVector2f(0.0f, 0.0f), FVector2f(1.0f, 0.0f), FVector2f(1.0f, 1.0f), FVector2f(0.0f, 1.0f) };
+
+	ArrowVertices.Reset(Arrows.Num() * 4);
+	ArrowIndices.Reset(Arrows.Num() * 6);
+
+	// Bake each arrow's rotation (around its center, like MakeRotatedBox) into its quad
+	for (const FArrowInstance& Arrow : Arrows)
+	{
+		const FVector2f Center = Arrow.Position + HalfArrowSize;
+		float Sin, Cos;
+		FMath::SinCos(&Sin, &Cos, Arrow.Rotation);
+
+		const SlateIndex FirstVertex = SlateIndex(ArrowVertices.Num());
+		for (const FVector2f& CornerUV : CornerUVs)
+		{
+			const FVector2f FromCenter = (CornerUV - FVector2f(0.5f)) * ArrowSize;
+			const FVector2f LocalPosition = Center + FVector2f(FromCenter.X * Cos - FromCenter.Y * Sin, FromCenter.X * Sin + FromCenter.Y * Cos);
+			ArrowVertices.Add(FSlateVertex::Make<ESlateVertexRounding::Disabled>(RenderTransform, LocalPosition, StartUV + CornerUV * SizeUV, ArrowColor));
+		}
+
+		ArrowIndices.Add(FirstVertex + 0);
+		ArrowIndices.Add(FirstVertex + 1);
+		ArrowIndices.Add(FirstVertex + 2);
+		ArrowIndices.Add(FirstVertex + 0);
+		ArrowIndices.Add(FirstVertex + 2);
+		ArrowIndices.Add(FirstVertex + 3);
+	}
+
+	FSlateDrawElement::MakeCustomVerts(
+		OutDrawElements,
+		LayerId,
+		ArrowResource,
+		ArrowVertices,
+		ArrowIndices,
+		nullptr,
+		0,
+		0,
+		bEnabled ? ESlateDrawEffect::None : ESlateDrawEffect::DisabledEffect);
+
+	return LayerId;
+}
+
 FString SActorCanvas::GetReferencerName() const
 {
 	return TEXT("SActorCanvas");
@@ -576,7 +881,7 @@ void SActorCanvas::AddIndicatorForEntry(UIndicatorDescriptor* Indicator)
 				}
 
 				// Create the widget from the pool.
-				if (UUserWidget* IndicatorWidget = IndicatorPool.GetOrCreateInstance(TSubclassOf<UUserWidget>(IndicatorClass.Get())))
+				if (UUserWidget* IndicatorWidget = AcquireIndicatorWidget(TSubclassOf<UUserWidget>(IndicatorClass.Get())))
 				{
 					if (IndicatorWidget->GetClass()->ImplementsInterface(UIndicatorWidgetInterface::StaticClass()))
 					{
@@ -612,7 +917,7 @@ void SActorCanvas::RemoveIndicatorForEntry(UIndicatorDescriptor* Indicator)
 
 		Indicator->IndicatorWidget = nullptr;
 		
-		IndicatorPool.Release(IndicatorWidget);
+		ReleaseIndicatorWidget(IndicatorWidget);
 	}
 
 	TSharedPtr<SWidget> CanvasHost = Indicator->CanvasHost.Pin();
@@ -623,14 +928,116 @@ void SActorCanvas::RemoveIndicatorForEntry(UIndicatorDescriptor* Indicator)
 	}
 }
 
+UUserWidget* SActorCanvas::AcquireIndicatorWidget(TSubclassOf<UUserWidget> WidgetClass)
+{
+	UUserWidget* IndicatorWidget = IndicatorPool.GetOrCreateInstance(WidgetClass);
+	if (IndicatorWidget)
+	{
+		FWidgetPoolStats& Stats = WidgetPoolStats.FindOrAdd(WidgetClass.Get());
+		if (Stats.NumFree > 0)
+		{
+			++Stats.NumHits;
+			--Stats.NumFree;
+		}
+		else
+		{
+			++Stats.NumMisses;
+		}
+
+		++Stats.NumLive;
+		Stats.PeakLive = FMath::Max(Stats.PeakLive, Stats.NumLive);
+	}
+
+	return IndicatorWidget;
+}
+
+void SActorCanvas::ReleaseIndicatorWidget(UUserWidget* IndicatorWidget)
+{
+	IndicatorPool.Release(IndicatorWidget);
+
+	if (FWidgetPoolStats* Stats = WidgetPoolStats.Find(IndicatorWidget->GetClass()))
+	{
+		--Stats->NumLive;
+		++Stats->NumFree;
+	}
+}
+
+void SActorCanvas::PrewarmIndicatorWidgets(TSoftClassPtr<UUserWidget> WidgetClass, int32 Count)
+{
+	if (WidgetClass.IsNull() || Count <= 0)
+	{
+		return;
+	}
+
+	AsyncLoad(WidgetClass, [this, WidgetClass, Count]() {
+		TSubclassOf<UUserWidget> LoadedClass = WidgetClass.Get();
+		if (!LoadedClass)
+		{
+			return;
+		}
+
+		FWidgetPoolStats& Stats = WidgetPoolStats.FindOrAdd(LoadedClass.Get());
+		const int32 NumToCreate = Count - (Stats.NumLive + Stats.NumFree);
+		if (NumToCreate <= 0)
+		{
+			return;
+		}
+
+		// The pool hands back its free instances of the class before it constructs new ones, so draw those out first and
+		// hold on to everything until the end, otherwise it could hand back an instance drawn in this loop
+		const int32 NumAlreadyFree = Stats.NumFree;
+		TArray<UUserWidget*, TInlineAllocator<16>> PrewarmedWidgets;
+		for (int32 Index = 0; Index < NumAlreadyFree + NumToCreate; ++Index)
+		{
+			if (UUserWidget* IndicatorWidget = IndicatorPool.GetOrCreateInstance(LoadedClass))
+			{
+				// Build the Slate widget too, the pool keeps it when the widget is released
+				IndicatorWidget->TakeWidget();
+				PrewarmedWidgets.Add(IndicatorWidget);
+			}
+		}
+
+		for (UUserWidget* IndicatorWidget : PrewarmedWidgets)
+		{
+			IndicatorPool.Release(IndicatorWidget);
+		}
+
+		// Only count what was actually constructed here, the free instances were already counted when they were released
+		const int32 NumConstructed = FMath::Max(PrewarmedWidgets.Num() - NumAlreadyFree, 0);
+		Stats.NumPrewarmed += NumConstructed;
+		Stats.NumFree += NumConstructed;
+	});
+	StartAsyncLoading();
+}
+
+void SActorCanvas::DumpWidgetPoolStats(FOutputDevice& Ar) const
+{
+	for (const TPair<TObjectKey<UClass>, FWidgetPoolStats>& Pair : WidgetPoolStats)
+	{
+		const UClass* WidgetClass = Pair.Key.ResolveObjectPtr();
+		const FWidgetPoolStats& Stats = Pair.Value;
+
+		Ar.Logf(TEXT("  %s: %d hits, %d misses, %d prewarmed, %d live (peak %d), %d free"),
+			WidgetClass ? *WidgetClass->GetName() : TEXT("<unloaded>"),
+			Stats.NumHits, Stats.NumMisses, Stats.NumPrewarmed, Stats.NumLive, Stats.PeakLive, Stats.NumFree);
+	}
+}
+
 SActorCanvas::FScopedWidgetSlotArguments SActorCanvas::AddActorSlot(UIndicatorDescriptor* Indicator)
 {
 	TWeakPtr<SActorCanvas> WeakCanvas = SharedThis(this);
 	return FScopedWidgetSlotArguments{ MakeUnique<FSlot>(Indicator), this->CanvasChildren, INDEX_NONE
-		, [WeakCanvas](const FSlot*, int32)
+		, [WeakCanvas](const FSlot*, int32 SlotIndex)
 		{
 			if (TSharedPtr<SActorCanvas> Canvas = WeakCanvas.Pin())
 			{
+				// New slots start out dirty, so the next arrange moves this one into place
+				for (int32& ChildIndex : Canvas->SortedSlotIndices)
+				{
+					ChildIndex += (ChildIndex >= SlotIndex) ? 1 : 0;
+				}
+				Canvas->SortedSlotIndices.Add(SlotIndex);
+
 				Canvas->UpdateActiveTimer();
 			}
 		}};
@@ -644,6 +1051,13 @@ int32 SActorCanvas::RemoveActorSlot(const TSharedRef<SWidget>& SlotWidget)
 		{
 			CanvasChildren.RemoveAt(SlotIdx);
 
+			// Keep the arrange order of the remaining slots
+			SortedSlotIndices.Remove(SlotIdx);
+			for (int32& ChildIndex : SortedSlotIndices)
+			{
+				ChildIndex -= (ChildIndex > SlotIdx) ? 1 : 0;
+			}
+
 			UpdateActiveTimer();
 
 			return SlotIdx;
@@ -47,6 +47,11 @@ public:
 	virtual void BeginPlay() override;
 	//~End of AActor interface
 
+	// Replaces the bots to create, only has an effect before BeginPlay (e.g. on a deferred spawn)
+	void SetBotCreationEntries(const TArray<FNLBotCreationEntry>& InBotCreationEntries, float InZoneRadius);
+
+	const TArray<TObjectPtr<AAIController>>& GetSpawnedBots() const { return SpawnedBotList; }
+
 #if WITH_EDITORONLY_DATA
 public:
 	UPROPERTY(VisibleAnywhere)
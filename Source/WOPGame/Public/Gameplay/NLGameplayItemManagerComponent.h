@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Components/ActorComponent.h"
+#include "GameFramework/GameplayMessageTypes2.h"
 #include "Net/Serialization/FastArraySerializer.h"
 #include "NLGameplayItemManagerComponent.generated.h"
 
@@ -34,6 +35,17 @@ struct FNLGameplayItemChangeMessage
 	int32 Delta = 0;
 };
 
+/** Coalesced change messages for the same instance report the latest count and the summed delta */
+template<>
+struct TGameplayMessageCoalescingTraits<FNLGameplayItemChangeMessage>
+{
+	static void Merge(FNLGameplayItemChangeMessage& PendingMessage, const FNLGameplayItemChangeMessage& NewMessage)
+	{
+		PendingMessage.NewCount = NewMessage.NewCount;
+		PendingMessage.Delta += NewMessage.Delta;
+	}
+};
+
 /** A single entry for a GameplayItem */
 USTRUCT(BlueprintType)
 struct FNLGameplayItemEntry : public FFastArraySerializerItem
@@ -37,3 +37,30 @@ struct FNLVerbMessage
 	// Returns a debug string representation of this message
 	WOPGAME_API FString ToString() const;
 };
+
+/**
+ * Several verb messages sent to a client in a single RPC
+ * Each message is delta encoded against the one before it (unchanged verbs, objects and tag sets cost a single bit) and magnitudes are quantized
+ */
+USTRUCT()
+struct FNLVerbMessageBatch
+{
+	GENERATED_BODY()
+
+	// Upper bound on messages per batch, larger bursts are split over several RPCs
+	static constexpr int32 MaxMessages = 64;
+
+	UPROPERTY()
+	TArray<FNLVerbMessage> Messages;
+
+	WOPGAME_API bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FNLVerbMessageBatch> : public TStructOpsTypeTraitsBase2<FNLVerbMessageBatch>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
@@ -32,4 +32,10 @@ public:
 
 	UFUNCTION(BlueprintCallable, Category = "NL")
 	static FNLVerbMessage CueParametersToVerbMessage(const FGameplayCueParameters& Params);
+
+	// Queues the message for the players owning its instigator and target (see ANLPlayerState::QueueClientMessage), so it
+	// reaches them batched with the rest of the frame's messages. Does nothing on clients.
+	// Only call this for verbs that something on the client listens for, every queued message costs bandwidth.
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "NL")
+	static void QueueMessageForInvolvedPlayers(const FNLVerbMessage& Message, bool bOnlyIfRelevant = false);
 };
@@ -0,0 +1,53 @@
+// Copyright 2025 Noblon GmbH. All Rights Reserved.
+
+#pragma once
+
+#include "Performance/NLHitchCapture.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+
+// Stats, CSV and trace instrumentation is compiled out of Shipping builds, only the hitch capture scopes remain there
+#define NL_STATS_ENABLED (!UE_BUILD_SHIPPING)
+
+DECLARE_STATS_GROUP(TEXT("WOPGame"), STATGROUP_WOPGame, STATCAT_Advanced);
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(WOPGAME_API, WOPGame);
+
+#if NL_STATS_ENABLED
+
+namespace NLStats
+{
+	// Set by NL.Stats.DetailedScopes, enables the scopes inside per-object loops and other high frequency code
+	extern WOPGAME_API bool bDetailedScopes;
+}
+
+// Cycle counters already emit trace events in builds with stats, builds without them (e.g. Test) still get the trace scope
+#if STATS
+	#define NL_CONDITIONAL_TRACE_SCOPE(Stat, bCondition)
+#else
+	#define NL_CONDITIONAL_TRACE_SCOPE(Stat, bCondition) TRACE_CPUPROFILER_EVENT_SCOPE_CONDITIONAL(Stat, bCondition)
+#endif
+
+/**
+ * Times a scope with a STATGROUP_WOPGame cycle counter (declared with DECLARE_CYCLE_STAT), a CSV profiler timing in the
+ * WOPGame category, an Insights trace event and a hitch capture event (see FNLHitchCapture)
+ */
+#define NL_CONDITIONAL_SCOPE_CYCLE_COUNTER(Stat, bCondition) \
+	CONDITIONAL_SCOPE_CYCLE_COUNTER(Stat, bCondition); \
+	CSV_CONDITIONAL_SCOPED_TIMING_STAT(WOPGame, Stat, bCondition); \
+	NL_CONDITIONAL_TRACE_SCOPE(Stat, bCondition); \
+	NL_HITCH_CAPTURE_SCOPE(TEXT(#Stat), bCondition)
+
+#define NL_SCOPE_CYCLE_COUNTER(Stat) NL_CONDITIONAL_SCOPE_CYCLE_COUNTER(Stat, true)
+
+// Fine grained scope, only recorded while NL.Stats.DetailedScopes is set
+#define NL_DETAILED_SCOPE_CYCLE_COUNTER(Stat) NL_CONDITIONAL_SCOPE_CYCLE_COUNTER(Stat, NLStats::bDetailedScopes)
+
+#else
+
+// Only the hitch capture ring buffers remain in Shipping, and only record while NL.HitchCapture is turned on
+#define NL_CONDITIONAL_SCOPE_CYCLE_COUNTER(Stat, bCondition) NL_HITCH_CAPTURE_SCOPE(TEXT(#Stat), bCondition)
+#define NL_SCOPE_CYCLE_COUNTER(Stat) NL_CONDITIONAL_SCOPE_CYCLE_COUNTER(Stat, true)
+#define NL_DETAILED_SCOPE_CYCLE_COUNTER(Stat)
+
+#endif // NL_STATS_ENABLED
@@ -6,6 +6,7 @@
 #include "GameplayEffectTypes.h"
 #include "Components/PawnComponent.h"
 #include "GameplayAbilitySpecHandle.h"
+#include "GameFramework/GameplayMessageTypes2.h"
 #include "NLPawnEffectManagerComponent.generated.h"
 
 namespace EEndPlayReason { enum Type : int; }
@@ -36,6 +37,17 @@ struct FNLPawnEffectStackChangeMessage
 	int32 Delta = 0;
 };
 
+/** Coalesced stack changes for the same effect keep the oldest previous count and report the latest count */
+template<>
+struct TGameplayMessageCoalescingTraits<FNLPawnEffectStackChangeMessage>
+{
+	static void Merge(FNLPawnEffectStackChangeMessage& PendingMessage, const FNLPawnEffectStackChangeMessage& NewMessage)
+	{
+		PendingMessage.NewStackCount = NewMessage.NewStackCount;
+		PendingMessage.Delta = PendingMessage.NewStackCount - PendingMessage.PreviousStackCount;
+	}
+};
+
 /**
  * Component that propagates pawn's Ability System Component effects upon relevancy.
  * This depends on a PawnExtensionComponent to coordinate initialization.
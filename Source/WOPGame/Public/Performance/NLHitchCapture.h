@@ -0,0 +1,157 @@
+// Copyright 2025 Noblon GmbH. All Rights Reserved.
+
+#pragma once
+
+#include "ChartCreation.h"
+#include "GameplayTagContainer.h"
+#include "HAL/PlatformTime.h"
+#include "UObject/NameTypes.h"
+
+#include <atomic>
+
+class UGameInstance;
+class UObject;
+struct FEndLoadPackageContext;
+struct IConsoleVariable;
+
+// The hitch capture ring buffers are compiled into all configurations, in Shipping NL.HitchCapture has to be turned on
+#ifndef NL_HITCH_CAPTURE_ENABLED
+	#define NL_HITCH_CAPTURE_ENABLED 1
+#endif
+
+#if NL_HITCH_CAPTURE_ENABLED
+
+namespace NLHitchCapture
+{
+	// Set by NL.HitchCapture, scopes are not recorded while it is off
+	extern WOPGAME_API bool bEnabled;
+
+	/**
+	 * Adds a timing event to the calling thread's ring buffer
+	 * @param Name		Must be a string with static lifetime (e.g. a literal), only the pointer is stored
+	 * @param Detail	Optional extra information, like the package of a load event
+	 */
+	WOPGAME_API void RecordEvent(const TCHAR* Name, uint64 StartCycles, uint64 EndCycles, FName Detail = NAME_None);
+
+	/**
+	 * Adds the time spent in the WOPGame scopes that ended in [SinceCycles, UntilCycles), on any thread, to InOutScopeMS
+	 * (keyed by the scope name, e.g. TEXT("STAT_NLTeamSubsystem_CompareTeams")). Only sees what is still in the ring
+	 * buffers, so call it at least once per frame.
+	 */
+	WOPGAME_API void SumScopeTimes(uint64 SinceCycles, uint64 UntilCycles, TMap<const TCHAR*, double>& InOutScopeMS);
+}
+
+// Records the duration of a scope into the calling thread's hitch capture ring buffer
+class FNLHitchCaptureScope
+{
+public:
+	FNLHitchCaptureScope(const TCHAR* InName, bool bCondition)
+		: Name((bCondition && NLHitchCapture::bEnabled) ? InName : nullptr)
+		, StartCycles(Name ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	~FNLHitchCaptureScope()
+	{
+		if (Name)
+		{
+			NLHitchCapture::RecordEvent(Name, StartCycles, FPlatformTime::Cycles64());
+		}
+	}
+
+private:
+	const TCHAR* Name;
+	uint64 StartCycles;
+};
+
+#define NL_HITCH_CAPTURE_SCOPE(Name, bCondition) FNLHitchCaptureScope PREPROCESSOR_JOIN(NLHitchCaptureScope_, __LINE__)(Name, bCondition)
+
+//////////////////////////////////////////////////////////////////////
+
+/**
+ * Writes the recent history of the hitch capture ring buffers to disk when a frame goes over budget
+ *
+ * Every thread that records an event owns a fixed size ring buffer, so the always-on cost is two cycle counter reads and
+ * a store per scope. When a frame takes longer than NL.HitchCapture.BudgetMS, the events of the last
+ * NL.HitchCapture.NumFrames frames (WOPGame scopes, garbage collections and package loads) are copied out together with
+ * the frame times and the gameplay message traffic of those frames, and written off the game thread as a Chrome trace event file
+ * (open it in Perfetto or chrome://tracing) to <ProfilingDir>/Hitches.
+ *
+ * Captures are rate limited by NL.HitchCapture.MinInterval and NL.HitchCapture.MaxPerSession.
+ *
+ * The message traffic comes from the gameplay message router's channel counters, so it is only included while
+ * GameplayMessageSubsystem.CollectStats is enabled.
+ */
+class FNLHitchCapture
+{
+public:
+	FNLHitchCapture();
+	~FNLHitchCapture();
+
+	// Called by the performance stat subsystem for every frame
+	void ProcessFrame(const IPerformanceDataConsumer::FFrameData& FrameData, const UGameInstance* GameInstance);
+
+	int32 GetNumCaptures() const { return NumCaptures; }
+
+private:
+	// Traffic of one gameplay message channel during one frame
+	struct FChannelFrameDelta
+	{
+		FGameplayTag Channel;
+		uint32 NumBroadcasts = 0;
+		uint32 NumDeliveries = 0;
+		uint64 CallbackCycles = 0;
+	};
+
+	// Cumulative channel counters as of the previous frame, to turn them into per-frame deltas
+	struct FChannelTotals
+	{
+		uint64 NumBroadcasts = 0;
+		uint64 NumDeliveries = 0;
+		uint64 CallbackCycles = 0;
+	};
+
+	struct FFrameRecord
+	{
+		uint64 FrameNumber = 0;
+		uint64 EndCycles = 0;
+		float FrameTime = 0.0f;
+		float GameThreadTime = 0.0f;
+		float RenderThreadTime = 0.0f;
+		float RHIThreadTime = 0.0f;
+		float GPUTime = 0.0f;
+
+		// Only channels that saw traffic this frame
+		TArray<FChannelFrameDelta> MessageDeltas;
+	};
+
+	void RecordMessageDeltas(FFrameRecord& Frame, const UGameInstance* GameInstance);
+	bool ShouldCapture(const FFrameRecord& Frame) const;
+	void Capture(const UGameInstance* GameInstance);
+
+	void HandlePreGarbageCollect();
+	void HandlePostGarbageCollect();
+	void HandleEndLoadPackage(const FEndLoadPackageContext& Context);
+
+private:
+	static constexpr int32 MaxFrames = 128;
+	FFrameRecord Frames[MaxFrames];
+	uint64 NumFrames = 0;
+
+	TMap<FGameplayTag, FChannelTotals> LastChannelTotals;
+	IConsoleVariable* CVarCollectMessageStats = nullptr;
+
+	double LastCaptureTime = 0.0;
+	int32 NumCaptures = 0;
+
+	// Set while a capture is being written, further hitches are ignored until then
+	TSharedRef<std::atomic<bool>> bWriteInFlight;
+
+	uint64 GarbageCollectStartCycles = 0;
+};
+
+#else
+
+#define NL_HITCH_CAPTURE_SCOPE(Name, bCondition)
+
+#endif // NL_HITCH_CAPTURE_ENABLED
@@ -0,0 +1,150 @@
+// Copyright 2025 Noblon GmbH. All Rights Reserved.
+
+#pragma once
+
+#include "Engine/EngineBaseTypes.h"
+#include "GameplayTagContainer.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/SoftObjectPath.h"
+
+#include "NLPerfRegressionSubsystem.generated.h"
+
+class AAIController;
+class ANLBotCreationActor;
+class FJsonObject;
+
+/**
+ * Headless performance regression run driven by bots
+ *
+ * Enabled by launching a map with -NLPerfTest=<BaselineName>, e.g.
+ *   WOPGameServer /Game/Maps/L_EditorDefaultLevel -nullrhi -unattended -NLPerfTest=EditorDefaultLevel8
+ *
+ * Once the world begins play it spawns a bot population through ANLBotCreationActor, keeps the bots moving around the
+ * navmesh and pressing the configured ability input tags, and records frame, game thread and server tick (world tick up to
+ * the end of actor ticking) times for a fixed duration after a warmup, together with the per-frame time of every WOPGame
+ * scope (NL_SCOPE_CYCLE_COUNTER, read from the hitch capture ring buffers). A CSV profile (including the WOPGame category)
+ * is captured alongside.
+ *
+ * The results are compared against Config/PerfBaselines/<BaselineName>.json, a report is written to
+ * Saved/PerfRegression and the process exits with 0 (pass), 1 (game thread, server tick or WOPGame scope time regressed)
+ * or 2 (the run could not be performed, including a baseline without recorded metrics). Passing -NLPerfTestUpdateBaseline
+ * writes the results as the new baseline instead, keeping its settings.
+ * WOPGame scopes that are not in the baseline yet are reported but don't fail the run.
+ *
+ * Run settings come from the baseline's "settings" object and can be overridden with -NLPerfTestBots=,
+ * -NLPerfTestWarmup= and -NLPerfTestDuration= (in seconds).
+ */
+UCLASS()
+class UNLPerfRegressionSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	//~USubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	//~End of USubsystem interface
+
+	//~UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	//~End of UWorldSubsystem interface
+
+	//~FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	//~End of FTickableGameObject interface
+
+private:
+	enum class ERunState : uint8
+	{
+		Idle,
+		Warmup,
+		Measure,
+		Finished,
+	};
+
+	struct FSettings
+	{
+		int32 NumBots = 8;
+		float WarmupSeconds = 10.0f;
+		float DurationSeconds = 60.0f;
+
+		// A metric regresses when it exceeds Baseline * (1 + TolerancePercent / 100) + AbsoluteToleranceMS
+		float TolerancePercent = 10.0f;
+		float AbsoluteToleranceMS = 0.25f;
+
+		float BotSpawnRadius = 2000.0f;
+		float MoveIntervalSeconds = 3.0f;
+		float InputIntervalSeconds = 1.0f;
+		TArray<FGameplayTag> InputTags;
+
+		// Defaults to the asset manager's default pawn data and AAIController
+		FSoftObjectPath BotPawnData;
+		FSoftClassPath BotControllerClass;
+
+		int32 Seed = 0;
+	};
+
+	struct FMetric
+	{
+		const TCHAR* Name = nullptr;
+
+		// Only these fail the run when they regress, the others are reported for information
+		bool bGated = false;
+
+		TArray<float> Samples;
+	};
+
+	void StartRun();
+	void FinishRun(int32 ExitCode, const FString& Report);
+
+	bool LoadSettings();
+	bool SpawnBots();
+	void DriveBots(float DeltaTime);
+
+	void HandleWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+	void HandleWorldPostActorTick(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+
+	void SampleScopeTimes();
+	TArray<const FMetric*> GetScopeMetrics() const;
+
+	static TSharedRef<FJsonObject> MakeMetricsJson(TConstArrayView<const FMetric*> Metrics);
+	TSharedRef<FJsonObject> MakeResultsJson() const;
+	bool CompareMetrics(const TCHAR* FieldName, TConstArrayView<const FMetric*> Metrics, const FJsonObject& Results, bool bRequireBaseline, FString& OutReport) const;
+	bool CompareToBaseline(FString& OutReport) const;
+
+	FString GetBaselineFilename() const;
+
+private:
+	FString BaselineName;
+	bool bUpdateBaseline = false;
+	FSettings Settings;
+	TSharedPtr<FJsonObject> Baseline;
+
+	ERunState State = ERunState::Idle;
+	double StateStartTime = 0.0;
+	double WorldTickStartTime = 0.0;
+	float LastServerTickMS = 0.0f;
+
+	FMetric FrameTimeMetric = { TEXT("frameMs"), false };
+	FMetric GameThreadTimeMetric = { TEXT("gameThreadMs"), true };
+	FMetric ServerTickTimeMetric = { TEXT("serverTickMs"), true };
+
+	// Per-frame time of each WOPGame scope, keyed by the stat name
+	TMap<FName, FMetric> ScopeMetrics;
+	TMap<const TCHAR*, double> FrameScopeMS;
+	uint64 LastScopeSampleCycles = 0;
+
+	FRandomStream RandomStream;
+	float TimeUntilNextMove = 0.0f;
+	float TimeUntilNextInput = 0.0f;
+	int32 NextInputTagIndex = 0;
+	bool bInputHeld = false;
+
+	UPROPERTY(Transient)
+	TObjectPtr<ANLBotCreationActor> BotCreationActor;
+
+	FDelegateHandle WorldTickStartHandle;
+	FDelegateHandle WorldPostActorTickHandle;
+};
@@ -3,12 +3,14 @@
 #pragma once
 
 #include "ChartCreation.h"
+#include "Performance/NLHitchCapture.h"
+#include "Performance/NLPerformanceStatTypes.h"
+#include "Performance/NLServerHealth.h"
 #include "Subsystems/GameInstanceSubsystem.h"
 
 #include "NLPerformanceStatSubsystem.generated.h"
 
-enum class ENLDisplayablePerformanceStat : uint8;
-
+class FNLPerformanceStatRecorder;
 class FSubsystemCollectionBase;
 class UNLPerformanceStatSubsystem;
 class UObject;
@@ -16,6 +18,69 @@ struct FFrame;
 
 //////////////////////////////////////////////////////////////////////
 
+// Fixed capacity history of one stat with O(1) rolling mean/min/max and percentiles
+class FNLPerformanceStatHistory
+{
+public:
+	// Number of frames kept
+	static constexpr int32 Capacity = 600;
+
+	FNLPerformanceStatHistory();
+
+	void AddSample(double Value);
+	void Reset();
+
+	int32 Num() const { return NumSamples; }
+	double GetLatest() const;
+	double GetMean() const { return (NumSamples > 0) ? (Sum / NumSamples) : 0.0; }
+	double GetMin() const;
+	double GetMax() const;
+
+	// Estimated value below which the given fraction (0..1) of the samples fall
+	double GetPercentile(double Fraction) const;
+
+	// Copies the samples out, oldest first
+	void GetSamples(TArray<float>& OutSamples) const;
+
+private:
+	// Percentiles come from a histogram over log spaced buckets covering [MinTrackedValue, MaxTrackedValue]
+	// (about 2% relative error), updated as samples enter and leave the window
+	static constexpr double MinTrackedValue = 1e-6;
+	static constexpr double MaxTrackedValue = 1e7;
+	static constexpr double BucketGrowth = 1.04;
+	static const int32 NumBuckets;
+
+	static int32 GetBucket(double Value);
+	static double GetBucketValue(int32 Bucket);
+
+	// Monotonic queue of sample sequence numbers, the front is the min (or max) of the window
+	struct FExtremumQueue
+	{
+		uint64 Sequences[Capacity];
+		uint64 Front = 0;
+		uint64 Back = 0;
+
+		bool IsEmpty() const { return Front == Back; }
+		uint64 GetFront() const { return Sequences[Front % Capacity]; }
+		uint64 GetBack() const { return Sequences[(Back - 1) % Capacity]; }
+	};
+
+	template <typename TPredicate>
+	void PushExtremum(FExtremumQueue& Queue, uint64 Sequence, double Value, TPredicate ShouldReplace);
+
+	double Samples[Capacity];
+	TArray<uint16> BucketCounts;
+	FExtremumQueue MinQueue;
+	FExtremumQueue MaxQueue;
+
+	// Sequence number of the next sample
+	uint64 NextSequence = 0;
+	int32 NumSamples = 0;
+	double Sum = 0.0;
+};
+
+//////////////////////////////////////////////////////////////////////
+
 // Observer which caches the stats for the previous frame
 struct FNLPerformanceStatCache : public IPerformanceDataConsumer
 {
@@ -23,7 +88,12 @@ public:
 	FNLPerformanceStatCache(UNLPerformanceStatSubsystem* InSubsystem)
 		: MySubsystem(InSubsystem)
 	{
+		StatHistory.SetNum((int32)ENLDisplayablePerformanceStat::Count);
+#if NL_HITCH_CAPTURE_ENABLED
+		HitchCapture = MakeUnique<FNLHitchCapture>();
+#endif
 	}
+	~FNLPerformanceStatCache();
 
 	//~IPerformanceDataConsumer interface
 	virtual void StartCharting() override;
@@ -33,11 +103,27 @@ public:
 
 	double GetCachedStat(ENLDisplayablePerformanceStat Stat) const;
 
+	const FNLPerformanceStatHistory& GetStatHistory(ENLDisplayablePerformanceStat Stat) const { return StatHistory[(int32)Stat]; }
+	FNLPerformanceStatSummary GetStatSummary(ENLDisplayablePerformanceStat Stat) const;
+
+	// Most recent hitches, oldest first
+	void GetRecentHitches(TArray<FNLPerformanceHitch>& OutHitches) const;
+	int64 GetNumHitches() const { return NumHitches; }
+
+	void ResetHistory();
+
+	// Stops streaming frames to disk (if NL.PerfStats.Record is set) and writes the summary of the recording
+	void StopRecording();
+
+protected:
+	void RecordHitch();
+	void UpdateRecording(bool bIsHitch);
+
 protected:
 	IPerformanceDataConsumer::FFrameData CachedData;
 	UNLPerformanceStatSubsystem* MySubsystem;
 
-	float CachedServerFPS = 0.0f;
+	FNLServerHealth CachedServerHealth;
 	float CachedPingMS = 0.0f;
 	float CachedPacketLossIncomingPercent = 0.0f;
 	float CachedPacketLossOutgoingPercent = 0.0f;
@@ -45,6 +131,21 @@ protected:
 	float CachedPacketRateOutgoing = 0.0f;
 	float CachedPacketSizeIncoming = 0.0f;
 	float CachedPacketSizeOutgoing = 0.0f;
+
+	TArray<FNLPerformanceStatHistory> StatHistory;
+
+	// Ring buffer of the most recent hitches
+	static constexpr int32 MaxRecentHitches = 64;
+	TArray<FNLPerformanceHitch> RecentHitches;
+	int64 NumHitches = 0;
+
+	// Streams frames to disk while NL.PerfStats.Record is set
+	TUniquePtr<FNLPerformanceStatRecorder> Recorder;
+
+#if NL_HITCH_CAPTURE_ENABLED
+	// Writes the recent scoped timings to disk when a frame goes over NL.HitchCapture.BudgetMS
+	TUniquePtr<FNLHitchCapture> HitchCapture;
+#endif
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -59,6 +160,25 @@ public:
 	UFUNCTION(BlueprintCallable)
 	double GetCachedStat(ENLDisplayablePerformanceStat Stat) const;
 
+	// Rolling mean, min, max and percentiles of a stat over the last FNLPerformanceStatHistory::Capacity frames
+	UFUNCTION(BlueprintCallable)
+	FNLPerformanceStatSummary GetStatSummary(ENLDisplayablePerformanceStat Stat) const;
+
+	// Recent values of a stat, oldest first (for graph display)
+	UFUNCTION(BlueprintCallable)
+	void GetStatHistorySamples(ENLDisplayablePerformanceStat Stat, TArray<float>& OutSamples) const;
+
+	// The most recent frames that took longer than NL.PerfStats.HitchThresholdMS, oldest first
+	UFUNCTION(BlueprintCallable)
+	TArray<FNLPerformanceHitch> GetRecentHitches() const;
+
+	// Number of hitches since the history was last reset
+	UFUNCTION(BlueprintCallable)
+	int64 GetNumHitches() const;
+
+	UFUNCTION(BlueprintCallable)
+	void ResetStatHistory();
+
 	//~USubsystem interface
 	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
 	virtual void Deinitialize() override;
@@ -77,6 +77,27 @@ enum class ENLDisplayablePerformanceStat : uint8
 	// The avg. size (in bytes) of packets sent
 	PacketSize_Outgoing,
 
+	// Server frame time (in seconds)
+	ServerFrameTime,
+
+	// Server game thread time (in seconds)
+	ServerFrameTime_GameThread,
+
+	// Fraction of the server frame the game thread was busy (%)
+	ServerGameThreadUtilization,
+
+	// CPU usage of the server process over all cores, including worker threads (%)
+	ServerCPUUtilization,
+
+	// Number of clients connected to the server
+	ServerConnections,
+
+	// Number of actors the server is replicating
+	ServerReplicatedActors,
+
+	// Outgoing server bandwidth over all connections (in KB/s)
+	ServerBandwidth_Outgoing,
+
 	// New stats should go above here
 	Count UMETA(Hidden)
 };
@@ -84,3 +105,73 @@ enum class ENLDisplayablePerformanceStat : uint8
 ENUM_RANGE_BY_COUNT(ENLDisplayablePerformanceStat, ENLDisplayablePerformanceStat::Count);
 
 //////////////////////////////////////////////////////////////////////
+
+// Rolling statistics of a performance stat over its recent history
+USTRUCT(BlueprintType)
+struct FNLPerformanceStatSummary
+{
+	GENERATED_BODY()
+
+	// Most recent sample
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	double Current = 0.0;
+
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	double Mean = 0.0;
+
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	double Min = 0.0;
+
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	double Max = 0.0;
+
+	// Percentiles are estimated with a relative error of a few percent
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	double P50 = 0.0;
+
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	double P95 = 0.0;
+
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	double P99 = 0.0;
+
+	// Number of frames the values above cover
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	int32 NumSamples = 0;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+// A frame that took longer than the hitch threshold (NL.PerfStats.HitchThresholdMS)
+USTRUCT(BlueprintType)
+struct FNLPerformanceHitch
+{
+	GENERATED_BODY()
+
+	// When the frame ended, in FPlatformTime::Seconds
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	double Timestamp = 0.0;
+
+	// When the frame ended, wall clock
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	FDateTime DateTime;
+
+	// Frame number (GFrameCounter) of the hitch
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	int64 FrameNumber = 0;
+
+	// Frame time and its breakdown, in seconds
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	float FrameTime = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	float GameThreadTime = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	float RenderThreadTime = 0.0f;
+
+	UPROPERTY(BlueprintReadOnly, Category = Performance)
+	float GPUTime = 0.0f;
+};
+
+//////////////////////////////////////////////////////////////////////
@@ -0,0 +1,75 @@
+// Copyright 2025 Noblon GmbH. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "NLServerHealth.generated.h"
+
+class UPackageMap;
+class UWorld;
+
+//////////////////////////////////////////////////////////////////////
+
+/**
+ * Snapshot of the server's load, sampled by the game state at a low rate (NL.ServerHealth.UpdateRate) and replicated to everyone
+ * Values are stored pre-quantized so the replicated form is only a dozen or so bytes, and unchanged samples don't replicate at all
+ */
+USTRUCT(BlueprintType)
+struct FNLServerHealth
+{
+	GENERATED_BODY()
+
+	// Fills in a snapshot of the current server load
+	static FNLServerHealth Sample(const UWorld* World);
+
+	// Average server tick rate (in Hz)
+	float GetTickRate() const { return TickRate; }
+
+	// Average frame time, and the time the last frame spent on the game thread and idle waiting for the tick rate limit (in seconds)
+	float GetFrameTime() const { return FrameTimeTenthsMS / 10000.0f; }
+	float GetGameThreadTime() const { return GameThreadTimeTenthsMS / 10000.0f; }
+	float GetIdleTime() const { return IdleTimeTenthsMS / 10000.0f; }
+
+	// Fraction of the last frame the game thread was busy (%)
+	float GetGameThreadUtilization() const { return GameThreadUtilization; }
+
+	// CPU usage of the whole server process, including worker threads, relative to all cores (%)
+	float GetProcessCPUUtilization() const { return ProcessCPUUtilization; }
+
+	int32 GetNumConnections() const { return NumConnections; }
+	int32 GetNumReplicatedActors() const { return NumReplicatedActors; }
+
+	// Outgoing bandwidth over all connections (in KB/s)
+	float GetBandwidthOut() const { return BandwidthOutKBps; }
+
+	WOPGAME_API bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FNLServerHealth& Other) const;
+	bool operator!=(const FNLServerHealth& Other) const { return !(*this == Other); }
+
+private:
+	// Uncapped servers (e.g. listen servers) easily tick faster than 255 Hz
+	uint16 TickRate = 0;
+	uint8 GameThreadUtilization = 0;
+	uint8 ProcessCPUUtilization = 0;
+
+	// Times are in 0.1 ms steps, saturating at 6.5 seconds
+	uint16 FrameTimeTenthsMS = 0;
+	uint16 GameThreadTimeTenthsMS = 0;
+	uint16 IdleTimeTenthsMS = 0;
+
+	uint32 NumConnections = 0;
+	uint32 NumReplicatedActors = 0;
+	uint32 BandwidthOutKBps = 0;
+};
+
+template<>
+struct TStructOpsTypeTraits<FNLServerHealth> : public TStructOpsTypeTraitsBase2<FNLServerHealth>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true,
+	};
+};
@@ -6,6 +6,7 @@
 #include "AbilitySystemInterface.h"
 #include "Teams/NLTeamAgentInterface.h"
 #include "GameFramework/PlayerState.h"
+#include "Messages/NLVerbMessage.h"
 #include "System/GameplayTagStack.h"
 #include "NLPlayerState.generated.h"
 
@@ -38,6 +39,7 @@ public:
     //~AActor interface
 	virtual void PreInitializeComponents() override;
 	virtual void PostInitializeComponents() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	//~End of AActor interface
 
 	//~APlayerState interface
@@ -83,6 +85,12 @@ public:
 	UFUNCTION(Client, Unreliable, BlueprintCallable, Category = "NL|PlayerState")
 	void ClientBroadcastMessage(const FNLVerbMessage Message);
 
+	// Queues a message for just this player, everything queued during a frame is sent in a single RPC when the net driver flushes
+	// (same delivery guarantees as ClientBroadcastMessage, prefer this when a server system sends several messages per frame)
+	// If bOnlyIfRelevant is set, the message is dropped when none of the actors it refers to are currently replicated to this player
+	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category = "NL|PlayerState")
+	void QueueClientMessage(const FNLVerbMessage& Message, bool bOnlyIfRelevant = false);
+
     FRotator GetReplicatedViewRotation() const;
 
     // Sets the replicated view rotation, only valid on the server
@@ -123,8 +131,23 @@ private:
     UPROPERTY(Replicated)
     FRotator ReplicatedViewRotation;
 
+	// Messages waiting for the next net driver flush, see QueueClientMessage
+	UPROPERTY(Transient)
+	TArray<FNLVerbMessage> PendingClientMessages;
+
+	// Parallel to PendingClientMessages, set for messages that are dropped when not relevant to this player
+	TBitArray<> PendingClientMessageRelevancyChecks;
+
+	FDelegateHandle TickFlushHandle;
+
 private:
 	UFUNCTION()
 	void OnRep_TeamID(FGenericTeamId OldTeamID);
 
+	UFUNCTION(Client, Unreliable)
+	void ClientReceiveMessageBatch(const FNLVerbMessageBatch& Batch);
+
+	void FlushClientMessages(float DeltaSeconds);
+	bool IsMessageRelevant(const FNLVerbMessage& Message) const;
+
 };
@@ -7,6 +7,21 @@
 
 class UGameplayEffect;
 class UObject;
+class UUserWidget;
+
+// An indicator widget class that is loaded and constructed before any indicator needs it
+USTRUCT()
+struct FNLIndicatorWidgetPrewarm
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, Category = "Indicators")
+	TSoftClassPtr<UUserWidget> WidgetClass;
+
+	// Number of instances to construct up front
+	UPROPERTY(EditDefaultsOnly, Category = "Indicators", meta = (ClampMin = 0))
+	int32 Count = 4;
+};
 
 /**
  * UNLGameData
@@ -38,4 +53,9 @@ public:
 	// Gameplay effect used to add and remove dynamic tags.
 	UPROPERTY(EditDefaultsOnly, Category = "Default Gameplay Effects")
 	TSoftClassPtr<UGameplayEffect> DynamicTagGameplayEffect;
+
+	// Indicator widgets every indicator layer loads and constructs when it is created, so indicators don't hitch when they first appear.
+	// Layers can add more per map (see UIndicatorLayer::PrewarmedWidgets), NL.Indicators.DumpPoolStats shows how well the sizes fit.
+	UPROPERTY(EditDefaultsOnly, Category = "Indicators")
+	TArray<FNLIndicatorWidgetPrewarm> PrewarmedIndicatorWidgets;
 };
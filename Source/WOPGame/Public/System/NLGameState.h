@@ -4,6 +4,7 @@
 
 #include "AbilitySystemInterface.h"
 #include "GameFramework/GameState.h"
+#include "Performance/NLServerHealth.h"
 #include "NLGameState.generated.h"
 
 struct FNLVerbMessage;
@@ -28,8 +29,8 @@ public:
 	//~AActor interface
 	virtual void PreInitializeComponents() override;
 	virtual void PostInitializeComponents() override;
+	virtual void BeginPlay() override;
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
-	virtual void Tick(float DeltaSeconds) override;
 	//~End of AActor interface
 
 	//~AGameStateBase interface
@@ -49,6 +50,12 @@ public:
 	// Gets the server's FPS, replicated to clients
 	float GetServerFPS() const;
 
+	// Gets the server's load, replicated to clients every 1 / NL.ServerHealth.UpdateRate seconds
+	const FNLServerHealth& GetServerHealth() const { return ServerHealth; }
+
+private:
+	void UpdateServerHealth();
+
 private:
 	// The ability system component subobject for game-wide things (primarily gameplay cues)
 	UPROPERTY(VisibleAnywhere, Category = "NL|GameState")
@@ -56,6 +63,8 @@ private:
 
 protected:
 	UPROPERTY(Replicated)
-	float ServerFPS;
+	FNLServerHealth ServerHealth;
+
+	FTimerHandle ServerHealthTimerHandle;
 
 };
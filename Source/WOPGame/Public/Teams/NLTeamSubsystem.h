@@ -2,16 +2,21 @@
 
 #pragma once
 
+#include "Containers/StaticBitArray.h"
+#include "Engine/TimerHandle.h"
 #include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
 
 #include "NLTeamSubsystem.generated.h"
 
 class AActor;
 class ANLPlayerState;
+class APawn;
 class ANLTeamInfoBase;
 class ANLTeamPrivateInfo;
 class ANLTeamPublicInfo;
 class FSubsystemCollectionBase;
+class INLTeamAgentInterface;
 class UNLTeamDisplayAsset;
 struct FFrame;
 struct FGameplayTag;
@@ -69,6 +74,10 @@ public:
 	virtual void Deinitialize() override;
 	//~End of USubsystem interface
 
+	//~UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	//~End of UWorldSubsystem interface
+
 	// Tries to registers a new team
 	bool RegisterTeamInfo(ANLTeamInfoBase* TeamInfo);
 
@@ -82,6 +91,9 @@ public:
 	// Returns the team this object belongs to, or INDEX_NONE if it is not part of a team
 	int32 FindTeamFromObject(const UObject* TestObject) const;
 
+	// Finds the teams of many objects in one pass (e.g., every target of an area of effect), OutTeamIds[i] is the team of Objects[i] or INDEX_NONE
+	void FindTeamsForObjects(TConstArrayView<const UObject*> Objects, TArray<int32>& OutTeamIds) const;
+
 	// Returns the associated player state for this actor, or INDEX_NONE if it is not associated with a player
 	const ANLPlayerState* FindPlayerStateFromActor(const AActor* PossibleTeamActor) const;
 
@@ -99,6 +111,10 @@ public:
 	// Returns true if the instigator can damage the target, taking into account the friendly fire settings
 	bool CanCauseDamage(const UObject* Instigator, const UObject* Target, bool bAllowDamageToSelf = true) const;
 
+	// Moves the targets the instigator can damage (see CanCauseDamage) to the front of Targets, keeping their order, and returns how many there are
+	// Meant for area of effect abilities, the instigator is only resolved once and each target costs a team lookup and a bit test
+	int32 FilterDamageableTargets(const UObject* Instigator, TArrayView<AActor*> Targets, bool bAllowDamageToSelf = true) const;
+
 	// Adds a specified number of stacks to the tag (does nothing if StackCount is below 1)
 	UFUNCTION(BlueprintCallable, BlueprintAuthorityOnly, Category=Teams)
 	void AddTeamTagStack(int32 TeamId, FGameplayTag Tag, int32 StackCount);
@@ -133,15 +149,104 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure=false, Category=Teams)
 	TArray<int32> GetTeamIDs() const;
 
+	// Gets the pawns of the specified team within Radius of Origin, without touching the physics scene
+	// Uses the positions from the last spatial update (see NL.Teams.SpatialUpdateRate)
+	UFUNCTION(BlueprintCallable, BlueprintPure=false, Category=Teams)
+	void QueryTeamMembersInRadius(int32 TeamId, FVector Origin, float Radius, TArray<APawn*>& OutPawns) const;
+
+	// Gets the pawns of every team the specified team can damage within Radius of Origin, without touching the physics scene
+	// Uses the positions from the last spatial update (see NL.Teams.SpatialUpdateRate)
+	UFUNCTION(BlueprintCallable, BlueprintPure=false, Category=Teams)
+	void QueryEnemiesInRadius(int32 TeamId, FVector Origin, float Radius, TArray<APawn*>& OutPawns) const;
+
 	// Called when a team display asset has been edited, causes all team color observers to update
 	void NotifyTeamDisplayAssetModified(UNLTeamDisplayAsset* ModifiedAsset);
 
 	// Register for a team display asset notification for the specified team ID
 	FOnNLTeamDisplayAssetChangedDelegate& GetTeamDisplayAssetChangedDelegate(int32 TeamId);
 
+private:
+	// Relationship between every pair of team ids (FGenericTeamId is a uint8, NoTeam included), indexed by the instigator's team id
+	// Only a fast path for the registered teams, ids without a team info fall back to comparing the ids
+	struct FTeamRelationshipMatrix
+	{
+		static constexpr int32 NumTeamIds = 256;
+
+		// Teams with a registered public or private team info
+		TStaticBitArray<NumTeamIds> RegisteredTeams;
+
+		// The teams are different and both are registered
+		TStaticBitArray<NumTeamIds> CanDamage[NumTeamIds];
+
+		// Both are on the same registered team
+		TStaticBitArray<NumTeamIds> Allies[NumTeamIds];
+	};
+
+	// Recomputes the relationship matrix, called when teams are registered or unregistered
+	void RebuildTeamRelationships();
+
+	// Comparison of already resolved team ids, INDEX_NONE on either side is an invalid argument
+	ENLTeamComparison CompareTeamIds(int32 TeamIdA, int32 TeamIdB) const;
+
+	// Damage test for an already resolved instigator team and target team
+	bool CanTeamDamageTarget(int32 InstigatorTeamId, int32 TargetTeamId, const UObject* Target) const;
+
+	// Resolves the team of an object that is not in the lookup cache, caching any team agent or team info found along the way
+	int32 FindTeamFromObject_Slow(const UObject* TestObject) const;
+
+	// Adds a team agent to the lookup cache and starts listening for its team changes, returns its team
+	int32 CacheTeamAgent(const UObject* AgentObject, const INLTeamAgentInterface* Agent) const;
+
+	void AddToTeamLookupCache(const UObject* Object, int32 TeamId) const;
+
+	UFUNCTION()
+	void HandleTeamAgentChangedTeam(UObject* ObjectChangingTeam, int32 OldTeamId, int32 NewTeamId);
+
+	// Pawn tracked by the spatial registry, it is only in a grid while it is part of a team
+	struct FSpatialMember
+	{
+		TWeakObjectPtr<APawn> Pawn;
+		FVector Location = FVector::ZeroVector;
+		int32 TeamId = INDEX_NONE;
+		FIntPoint Cell = FIntPoint::ZeroValue;
+	};
+
+	// Members of one team bucketed into SpatialCellSize sized cells on the XY plane (values are indices into SpatialMembers)
+	using FSpatialGrid = TMap<FIntPoint, TArray<int32>>;
+
+	void HandleActorSpawned(AActor* Actor);
+
+	// Refreshes the team and cell of every tracked pawn and drops the destroyed ones, re-arms itself at NL.Teams.SpatialUpdateRate
+	void UpdateSpatialRegistry();
+
+	FIntPoint GetSpatialCell(const FVector& Location) const;
+	void AddToSpatialGrid(int32 MemberIndex);
+	void RemoveFromSpatialGrid(int32 MemberIndex);
+	void GatherSpatialMembers(const FSpatialGrid& Grid, const FVector& Origin, float Radius, TArray<APawn*>& OutPawns) const;
+
 private:
 	UPROPERTY()
 	TMap<int32, FNLTeamTrackingInfo> TeamMap;
 
+	TUniquePtr<FTeamRelationshipMatrix> TeamRelationships;
+
+	// Team of every team agent and team info seen so far, kept up to date through the agents' team changed delegates
+	// (filled in lazily by lookups, which are logically const)
+	mutable TMap<FObjectKey, int32> TeamLookupCache;
+
+	// Entries of destroyed objects are pruned when the cache grows past this size
+	mutable int32 TeamLookupCachePruneSize = 0;
+
+	TSparseArray<FSpatialMember> SpatialMembers;
+
+	// Grid of each team's members, by team id
+	TMap<int32, FSpatialGrid> SpatialGrids;
+
+	// Cell size the grids were built with, zero until the first spatial update
+	float SpatialCellSize = 0.0f;
+
+	FTimerHandle SpatialUpdateTimerHandle;
+	FDelegateHandle ActorSpawnedHandle;
+
 	FDelegateHandle CheatManagerRegistrationHandle;
 };
@@ -14,9 +14,130 @@ class UUserWidget;
 struct FFrame;
 struct FSceneViewProjectionData;
 
-struct FIndicatorProjection
+/**
+ * World space points an indicator is projected from, see FIndicatorBatchProjection::GatherAnchor
+ * Gathering reads socket transforms and bounds, so the canvas can keep an anchor for a few frames and still re-project it every frame.
+ */
+struct FIndicatorAnchor
+{
+	// Point the depth is measured to, and the projected point for the point and bounding box anchor modes
+	FVector Point = FVector::ZeroVector;
+
+	// Box whose projected corners are used by the screen bounding box modes
+	FBox ScreenBox = FBox(ForceInit);
+
+	bool bUseScreenBox = false;
+};
+
+/**
+ * Actor bounds shared by all indicators on the same actor.
+ * AActor::GetComponentsBoundingBox walks every component, so the result is kept until the actor's root moves
+ * or one of its components has its render state marked dirty. Component bounds are already cached by the component itself.
+ * Actors whose bounds change without either happening (animated skinned meshes, components attached to a socket or to
+ * another actor) are recomputed on every update.
+ */
+class FIndicatorBoundsCache
+{
+public:
+	FIndicatorBoundsCache();
+	~FIndicatorBoundsCache();
+
+	FIndicatorBoundsCache(const FIndicatorBoundsCache&) = delete;
+	FIndicatorBoundsCache& operator=(const FIndicatorBoundsCache&) = delete;
+
+	FBox GetActorBounds(const AActor& Actor, uint32 UpdateCounter);
+
+	// Forgets actors that were not asked about for a while
+	void RemoveStaleEntries(uint32 UpdateCounter, uint32 MaxAge);
+
+private:
+	void OnRenderStateDirty(UActorComponent& Component);
+
+	static bool HasVolatileBounds(const AActor& Actor);
+
+	struct FEntry
+	{
+		FTransform RootTransform;
+		FBox Bounds = FBox(ForceInit);
+		uint32 LastUsed = 0;
+		bool bDirty = true;
+		// Set when the bounds can't be cached, see HasVolatileBounds
+		bool bVolatile = false;
+	};
+
+	TMap<TObjectKey<AActor>, FEntry> Entries;
+	FDelegateHandle RenderStateDirtyHandle;
+};
+
+/**
+ * Projects many indicators with a single view-projection matrix.
+ * Anchor points (component point, socket or bounding box corners) are gathered into SoA arrays relative to the view origin
+ * and transformed 4 at a time, the per indicator results match ULocalPlayer::GetPixelPoint / GetPixelBoundingBox.
+ * Allocations are kept between frames, so a batch that is reused does not allocate in steady state.
+ */
+struct FIndicatorBatchProjection
+{
+	// Reads the world space anchor of an indicator, returns false if it can't be projected
+	// Actor bounds come from BoundsCache when one is given
+	static bool GatherAnchor(const UIndicatorDescriptor& IndicatorDescriptor, FIndicatorAnchor& OutAnchor, FIndicatorBoundsCache* BoundsCache = nullptr, uint32 UpdateCounter = 0);
+
+	// Clears the indicators of the previous frame
+	void Reset(const FSceneViewProjectionData& InProjectionData, const FVector2f& InScreenSize);
+
+	// Adds an indicator to project this frame, returns the index to fetch the result with
+	int32 AddIndicator(const UIndicatorDescriptor& IndicatorDescriptor, const FIndicatorAnchor& Anchor);
+
+	// Projects all gathered anchor points
+	void Project();
+
+	// Returns the screen position (XY) and distance to the view origin (Z) of an indicator
+	const FVector& GetScreenPositionWithDepth(int32 ResultIndex) const { return Results[ResultIndex]; }
+
+	int32 Num() const { return Entries.Num(); }
+
+private:
+	void AddPoint(const FVector& WorldPoint);
+
+	struct FEntry
+	{
+		FVector BoundingBoxAnchor;
+		FVector2D ScreenSpaceOffset;
+		// Index of the point the depth is measured to, followed by the points to project
+		int32 FirstPoint = 0;
+		// 1 for point projection modes, 8 box corners for screen bounding box modes
+		int32 NumProjectedPoints = 1;
+	};
+
+	FVector ViewOrigin = FVector::ZeroVector;
+	FMatrix44f ViewProjectionMatrix = FMatrix44f::Identity;
+	FVector2f ScreenSize = FVector2f::ZeroVector;
+
+	TArray<FEntry> Entries;
+	TArray<FVector> Results;
+
+	// Anchor points relative to the view origin
+	TArray<float, TAlignedHeapAllocator<16>> PointX;
+	TArray<float, TAlignedHeapAllocator<16>> PointY;
+	TArray<float, TAlignedHeapAllocator<16>> PointZ;
+
+	// Projected pixel positions, view space W (negative behind the camera) and distance to the view origin
+	TArray<float, TAlignedHeapAllocator<16>> PixelX;
+	TArray<float, TAlignedHeapAllocator<16>> PixelY;
+	TArray<float, TAlignedHeapAllocator<16>> PointW;
+	TArray<float, TAlignedHeapAllocator<16>> PointDistance;
+};
+
+/** How often the canvas refreshes an indicator's world position (it is re-projected every frame regardless) */
+UENUM(BlueprintType)
+enum class EIndicatorUpdateTier : uint8
 {
-	bool Project(const UIndicatorDescriptor& IndicatorDescriptor, const FSceneViewProjectionData& InProjectionData, const FVector2f& ScreenSize, FVector& ScreenPositionWithDepth);
+	// Every frame or reduced, picked from priority and distance to the view (see NL.Indicators.LOD.* cvars)
+	Automatic,
+	EveryFrame,
+	// Every few frames (NL.Indicators.LOD.ReducedUpdateInterval)
+	Reduced,
+	// Read once, for indicators on things that don't move
+	Frozen
 };
 
 UENUM(BlueprintType)
@@ -158,6 +279,33 @@ public:
 		ScreenSpaceOffset = Offset;
 	}
 
+	// How often the world position is refreshed
+	UFUNCTION(BlueprintCallable)
+	EIndicatorUpdateTier GetUpdateTier() const { return UpdateTier; }
+	UFUNCTION(BlueprintCallable)
+	void SetUpdateTier(EIndicatorUpdateTier InUpdateTier)
+	{
+		UpdateTier = InUpdateTier;
+	}
+
+	// Skip projecting the indicator while it is outside the view? (never applies to indicators clamped to the screen)
+	UFUNCTION(BlueprintCallable)
+	bool GetCullWhenOffscreen() const { return bCullWhenOffscreen; }
+	UFUNCTION(BlueprintCallable)
+	void SetCullWhenOffscreen(bool bValue)
+	{
+		bCullWhenOffscreen = bValue;
+	}
+
+	// Merge with nearby indicators of the same widget class into a single cluster showing a count?
+	UFUNCTION(BlueprintCallable)
+	bool GetAllowClustering() const { return bAllowClustering; }
+	UFUNCTION(BlueprintCallable)
+	void SetAllowClustering(bool bValue)
+	{
+		bAllowClustering = bValue;
+	}
+
 	UFUNCTION(BlueprintCallable)
 	FVector GetBoundingBoxAnchor() const { return BoundingBoxAnchor; }
 	UFUNCTION(BlueprintCallable)
@@ -171,7 +319,7 @@ public:
 	//=======================
 
 	// Allows sorting the indicators (after they are sorted by depth), to allow some group of indicators
-	// to always be in front of others.
+	// to always be in front of others. Higher priorities are also kept when there are too many indicators to show.
 	UFUNCTION(BlueprintCallable)
 	int32 GetPriority() const { return Priority; }
 	UFUNCTION(BlueprintCallable)
@@ -198,6 +346,10 @@ private:
 	bool bOverrideScreenPosition = false;
 	UPROPERTY()
 	bool bAutoRemoveWhenIndicatorComponentIsNull = false;
+	UPROPERTY()
+	bool bCullWhenOffscreen = true;
+	UPROPERTY()
+	bool bAllowClustering = false;
 
 	UPROPERTY()
 	EActorCanvasProjectionMode ProjectionMode = EActorCanvasProjectionMode::ComponentPoint;
@@ -205,6 +357,8 @@ private:
 	TEnumAsByte<EHorizontalAlignment> HAlignment = HAlign_Center;
 	UPROPERTY()
 	TEnumAsByte<EVerticalAlignment> VAlignment = VAlign_Center;
+	UPROPERTY()
+	EIndicatorUpdateTier UpdateTier = EIndicatorUpdateTier::Automatic;
 
 	UPROPERTY()
 	int32 Priority = 0;
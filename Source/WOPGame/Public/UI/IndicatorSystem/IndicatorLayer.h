@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Components/Widget.h"
+#include "System/NLGameData.h"
 
 #include "IndicatorLayer.generated.h"
 
@@ -20,6 +21,24 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Appearance)
 	FSlateBrush ArrowBrush;
 
+	/** Background of the badge shown in place of indicators merged into a cluster. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Appearance)
+	FSlateBrush ClusterBrush;
+
+	/** Font of the indicator count on cluster badges. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category=Appearance)
+	FSlateFontInfo ClusterFont;
+
+	/** Indicator widgets to construct when the layer is created, in addition to the ones listed in the game data. */
+	UPROPERTY(EditAnywhere, Category=Indicators)
+	TArray<FNLIndicatorWidgetPrewarm> PrewarmedWidgets;
+
+	/** Loads an indicator widget class and makes sure at least Count instances are constructed, so indicators using it appear without a hitch. */
+	UFUNCTION(BlueprintCallable, Category=Indicators)
+	void PrewarmIndicatorWidgets(TSoftClassPtr<UUserWidget> WidgetClass, int32 Count);
+
+	TSharedPtr<SActorCanvas> GetActorCanvas() const { return MyActorCanvas; }
+
 protected:
 	// UWidget interface
 	virtual void ReleaseSlateResources(bool bReleaseChildren) override;
@@ -4,11 +4,15 @@
 
 #include "AsyncMixin.h"
 #include "Blueprint/UserWidgetPool.h"
+#include "Fonts/SlateFontInfo.h"
+#include "Rendering/RenderingCommon.h"
+#include "UI/IndicatorSystem/IndicatorDescriptor.h"
 #include "Widgets/SPanel.h"
 
 class FActiveTimerHandle;
 class FArrangedChildren;
 class FChildren;
+class FOutputDevice;
 class FPaintArgs;
 class FReferenceCollector;
 class FSlateRect;
@@ -36,6 +40,10 @@ public:
 			, bInFrontOfCamera(true)
 			, bHasValidScreenPosition(false)
 			, bDirty(true)
+			, bHasAnchor(false)
+			, bIsWithinBudget(true)
+			, bIsClustered(false)
+			, bSortKeyDirty(true)
 			, bWasIndicatorClamped(false)
 			, bWasIndicatorClampedStatusChanged(false)
 		{
@@ -74,6 +82,7 @@ public:
 			{
 				Depth = InDepth;
 				bDirty = true;
+				bSortKeyDirty = true;
 			}
 		}
 
@@ -84,6 +93,7 @@ public:
 			{
 				Priority = InPriority;
 				bDirty = true;
+				bSortKeyDirty = true;
 			}
 		}
 
@@ -111,6 +121,30 @@ public:
 			RefreshVisibility();
 		}
 
+		bool IsWithinBudget() const { return bIsWithinBudget; }
+		void SetIsWithinBudget(bool bWithinBudget)
+		{
+			if (bIsWithinBudget != bWithinBudget)
+			{
+				bIsWithinBudget = bWithinBudget;
+				bDirty = true;
+			}
+
+			RefreshVisibility();
+		}
+
+		bool IsClustered() const { return bIsClustered; }
+		void SetIsClustered(bool bClustered)
+		{
+			if (bIsClustered != bClustered)
+			{
+				bIsClustered = bClustered;
+				bDirty = true;
+			}
+
+			RefreshVisibility();
+		}
+
 		bool bIsDirty() const { return bDirty; }
 
 		void ClearDirtyFlag()
@@ -137,7 +171,7 @@ public:
 	private:
 		void RefreshVisibility()
 		{
-			const bool bIsVisible = bIsIndicatorVisible && bHasValidScreenPosition;
+			const bool bIsVisible = bIsIndicatorVisible && bHasValidScreenPosition && bIsWithinBudget && !bIsClustered;
 			GetWidget()->SetVisibility(bIsVisible ? EVisibility::SelfHitTestInvisible : EVisibility::Collapsed);
 		}
 
@@ -147,10 +181,22 @@ public:
 		double Depth;
 		int32 Priority;
 
+		/** World space anchor, refreshed according to the indicator's update tier */
+		FIndicatorAnchor Anchor;
+		uint32 LastAnchorUpdate = 0;
+
 		uint8 bIsIndicatorVisible : 1;
 		uint8 bInFrontOfCamera : 1;
 		uint8 bHasValidScreenPosition : 1;
 		uint8 bDirty : 1;
+		uint8 bHasAnchor : 1;
+		/** False while evicted because more indicators want to show than NL.Indicators.MaxVisible allows */
+		uint8 bIsWithinBudget : 1;
+		/** True while merged into a cluster, the cluster is drawn in place of the indicator */
+		uint8 bIsClustered : 1;
+
+		/** Set when the priority or depth changed since the canvas last ordered its slots */
+		mutable uint8 bSortKeyDirty : 1;
 		
 		/** 
 		 * Cached & frame-deferred value of whether the indicator was visually screen clamped last frame or not; 
@@ -162,11 +208,6 @@ public:
 		friend class SActorCanvas;
 	};
 
-	/** ActorCanvas-specific slot class */
-	class FArrowSlot : public TSlotBase<FArrowSlot>
-	{
-	};
-
 	/** Begin the arguments for this slate widget */
 	SLATE_BEGIN_ARGS(SActorCanvas) {
 		_Visibility = EVisibility::HitTestInvisible;
@@ -174,17 +215,19 @@ public:
 
 		/** Indicates that we have a slot that this widget supports */
 		SLATE_SLOT_ARGUMENT(SActorCanvas::FSlot, Slots)
+
+		/** Background drawn behind the count of clustered indicators */
+		SLATE_ARGUMENT(const FSlateBrush*, ClusterBrush)
+
+		/** Font of the count of clustered indicators */
+		SLATE_ARGUMENT(FSlateFontInfo, ClusterFont)
 	
 	/** This always goes at the end */
 	SLATE_END_ARGS()
 
 	SActorCanvas()
 		: CanvasChildren(this)
-		, ArrowChildren(this)
-		, AllChildren(this)
 	{
-		AllChildren.AddChildren(CanvasChildren);
-		AllChildren.AddChildren(ArrowChildren);
 	}
 
 	void Construct(const FArguments& InArgs, const FLocalPlayerContext& InCtx, const FSlateBrush* ActorCanvasArrowBrush);
@@ -192,12 +235,34 @@ public:
 	// SWidget Interface
 	virtual void OnArrangeChildren( const FGeometry& AllottedGeometry, FArrangedChildren& ArrangedChildren ) const override;
 	virtual FVector2D ComputeDesiredSize(float) const override { return FVector2D::ZeroVector; }
-	virtual FChildren* GetChildren() override { return &AllChildren; }
+	virtual FChildren* GetChildren() override { return &CanvasChildren; }
 	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const;
 	// End SWidget
 
 	void SetDrawElementsInOrder(bool bInDrawElementsInOrder) { bDrawElementsInOrder = bInDrawElementsInOrder; }
 
+	/** Usage of the indicator widget pool for one widget class */
+	struct FWidgetPoolStats
+	{
+		/** Indicators that were given an already constructed widget */
+		int32 NumHits = 0;
+		/** Indicators that had to construct a new widget */
+		int32 NumMisses = 0;
+		/** Widgets constructed ahead of time by PrewarmIndicatorWidgets */
+		int32 NumPrewarmed = 0;
+		/** Widgets currently bound to an indicator, and the most there ever were at once */
+		int32 NumLive = 0;
+		int32 PeakLive = 0;
+		/** Constructed widgets waiting in the pool */
+		int32 NumFree = 0;
+	};
+
+	/** Async loads an indicator widget class and constructs instances until at least Count are pooled or in use */
+	void PrewarmIndicatorWidgets(TSoftClassPtr<UUserWidget> WidgetClass, int32 Count);
+
+	const TMap<TObjectKey<UClass>, FWidgetPoolStats>& GetWidgetPoolStats() const { return WidgetPoolStats; }
+	void DumpWidgetPoolStats(FOutputDevice& Ar) const;
+
 	virtual FString GetReferencerName() const override;
 	virtual void AddReferencedObjects( FReferenceCollector& Collector ) override;
 	
@@ -208,6 +273,9 @@ private:
 	void AddIndicatorForEntry(UIndicatorDescriptor* Indicator);
 	void RemoveIndicatorForEntry(UIndicatorDescriptor* Indicator);
 
+	UUserWidget* AcquireIndicatorWidget(TSubclassOf<UUserWidget> WidgetClass);
+	void ReleaseIndicatorWidget(UUserWidget* IndicatorWidget);
+
 	using FScopedWidgetSlotArguments = TPanelChildren<FSlot>::FScopedWidgetSlotArguments;
 	FScopedWidgetSlotArguments AddActorSlot(UIndicatorDescriptor* Indicator);
 	int32 RemoveActorSlot(const TSharedRef<SWidget>& SlotWidget);
@@ -224,6 +292,22 @@ private:
 
 	void UpdateActiveTimer();
 
+	int32 PaintArrows(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bEnabled) const;
+
+	/** Whether the world space anchor of a slot is due to be read again this update */
+	bool ShouldRefreshAnchor(const FSlot& Slot, const FVector& ViewOrigin) const;
+
+	/** Merges nearby projected indicators that allow it into clusters */
+	void UpdateClusters(const FVector2f& ScreenSize);
+
+	int32 PaintClusters(const FGeometry& AllottedGeometry, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bEnabled) const;
+
+	/** Evicts the lowest priority (then furthest) projected indicators above the visible indicator budget */
+	void ApplyVisibilityBudget(const FVector2f& ScreenSize);
+
+	/** Brings SortedSlotIndices up to date, only re-sorting when a slot's priority or depth changed */
+	void UpdateSlotOrder() const;
+
 private:
 	TArray<TObjectPtr<UIndicatorDescriptor>> AllIndicators;
 	TArray<UIndicatorDescriptor*> InactiveIndicators;
@@ -233,15 +317,26 @@ private:
 
 	/** All the slots in this canvas */
 	TPanelChildren<FSlot> CanvasChildren;
-	mutable TPanelChildren<FArrowSlot> ArrowChildren;
-	FCombinedChildren AllChildren;
 
 	FUserWidgetPool IndicatorPool;
+	TMap<TObjectKey<UClass>, FWidgetPoolStats> WidgetPoolStats;
 
 	const FSlateBrush* ActorCanvasArrowBrush = nullptr;
 
-	mutable int32 NextArrowIndex = 0;
-	mutable int32 ArrowIndexLastUpdate = 0;
+	/** CanvasChildren indices in arrange order (by priority, then back to front), maintained incrementally */
+	mutable TArray<int32> SortedSlotIndices;
+
+	/** An arrow pointing at an indicator clamped to the screen edge, in canvas space */
+	struct FArrowInstance
+	{
+		FVector2f Position;
+		float Rotation;
+	};
+
+	/** Arrows placed by the last arrange, drawn as a single element on top of the indicators */
+	mutable TArray<FArrowInstance> Arrows;
+	mutable TArray<FSlateVertex> ArrowVertices;
+	mutable TArray<SlateIndex> ArrowIndices;
 
 	/** Whether to draw elements in the order they were added to canvas. Note: Enabling this will disable batching and will cause a greater number of drawcalls */
 	bool bDrawElementsInOrder = false;
@@ -250,5 +345,42 @@ private:
 
 	mutable TOptional<FGeometry> OptionalPaintGeometry;
 
+	/** Projects all visible indicators at once, kept between updates to reuse its allocations */
+	FIndicatorBatchProjection BatchProjection;
+
+	/** Actor bounds shared by the indicators of the bounding box projection modes */
+	FIndicatorBoundsCache BoundsCache;
+
+	/** CanvasChildren index of every indicator in BatchProjection, in the same order */
+	TArray<int32> ProjectedChildIndices;
+
+	/** Indicators within a few pixels of each other, drawn as one badge with a count */
+	struct FIndicatorCluster
+	{
+		/** Position of the first member, others join by distance to it */
+		FVector2f Seed;
+		FVector2f PositionSum;
+		const UClass* WidgetClass;
+		int32 FirstMember;
+		int32 NumMembers;
+		/** Next cluster seeded in the same spatial hash cell */
+		int32 NextInCell;
+	};
+
+	TArray<FIndicatorCluster> Clusters;
+	/** CanvasChildren index of the next member of the same cluster, parallel to CanvasChildren */
+	TArray<int32> NextClusterMember;
+	/** First cluster seeded in each screen space cell */
+	TMap<FIntPoint, int32> ClusterCells;
+
+	const FSlateBrush* ClusterBrush = nullptr;
+	FSlateFontInfo ClusterFont;
+
+	/** Scratch list of CanvasChildren indices competing for the visible indicator budget */
+	TArray<int32> BudgetCandidates;
+
+	/** Number of canvas updates, drives reduced update tiers */
+	uint32 UpdateCounter = 0;
+
 	TSharedPtr<FActiveTimerHandle> TickHandle;
 };
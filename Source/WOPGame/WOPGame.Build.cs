@@ -21,7 +21,7 @@ public class WOPGame : ModuleRules
 
 		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "InputCore", "EnhancedInput", "AIModule", "ModularGameplay", "NavigationSystem", "Niagara", "CommonLoadingScreen", "ApplicationCore", "AsyncMixin", "PhysicsCore" });
 
-		PrivateDependencyModuleNames.AddRange(new string[] { "NetCore", "Slate", "SlateCore", "UMG", "GameplayAbilities", "GameplayTags", "GameplayTasks", "GameplayMessageRuntime", "AudioModulation", "CommonUI", "CommonInput", "AudioMixer", "DeveloperSettings", "RHI", "CommonGame", "UIExtension" });
+		PrivateDependencyModuleNames.AddRange(new string[] { "NetCore", "Slate", "SlateCore", "UMG", "GameplayAbilities", "GameplayTags", "GameplayTasks", "GameplayMessageRuntime", "AudioModulation", "CommonUI", "CommonInput", "AudioMixer", "DeveloperSettings", "RHI", "CommonGame", "UIExtension", "Json" });
 
         DynamicallyLoadedModuleNames.AddRange(
             new string[] {